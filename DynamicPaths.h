@@ -0,0 +1,350 @@
+﻿#ifndef _DYNAMIC_PATHS_H_		//防止头文件被重复包含
+#define _DYNAMIC_PATHS_H_
+
+#include "stdafx.h"
+#include "Graph.h"
+
+/*
+ * 动态最短路径
+ * 维护若干棵最短路径树以及一组终点(起点,终点,必经结点等)两两之间的距离表
+ * 通过update批量修改边后,参照Ramalingam-Reps算法增量修复,只访问受影响的结点：
+ *   1. 权值变大或被删除的树边,其子树中的结点受影响,距离先置为∞,再由不受影响的前驱结点确定初始距离
+ *   2. 权值变小或新插入的边如能缩短终点的距离,则更新终点
+ *   3. 以上结点按距离入堆,用Dijkstra算法向后传播
+ * 边的权值必须为正;各棵树互不相关,修复时并行进行
+ * 入边索引在构造时建立,插入新边改变存储位置后重新建立
+ * 保存graph的引用,修改有向图必须通过本类的update,否则最短路径树不会被修复
+ * 应用举例：
+ * DynamicShortestPaths<double> dsp(graph);
+ * size_t tree = dsp.addTree(0);
+ * dsp.setTerminals({ 0, 17, 7, 12 });
+ * dsp.update({ { { 2, 4 }, 6.0 }, { { 4, 5 }, 0.0 } });	//修改2->4的权值,删除4->5
+ * double d = dsp.distance(tree, 17);
+ * double t = dsp.terminalDistance(0, 1);
+ */
+template <typename ValueType, typename IndexType = int>
+class DynamicShortestPaths
+{
+private:
+	typedef typename Graph<ValueType, IndexType>::EdgeIterator EdgeIterator;
+	typedef typename Graph<ValueType, IndexType>::LineType LineType;
+	typedef pair<ValueType, IndexType> HeapItem;
+	typedef priority_queue<HeapItem, vector<HeapItem>, greater<HeapItem>> Heap;
+
+	const ValueType unreached = numeric_limits<ValueType>::max();
+	const IndexType npos = Graph<ValueType, IndexType>::npos;
+
+	//最短路径树(内部编号)
+	struct Tree
+	{
+		IndexType root;
+		bool toRoot;				//false: root到各结点的距离; true: 各结点到root的距离
+		vector<ValueType> dist;
+		vector<IndexType> parent;	//toRoot时为到root的路径上的下一个结点
+		vector<bool> affected;		//修复时使用的工作区
+	};
+
+	Graph<ValueType, IndexType> &graph;
+	vector<Tree> trees;
+	vector<IndexType> terminals;		//终点(输入编号)
+	vector<size_t> terminalTrees;		//以各终点为根的树
+	vector<size_t> freeTrees;			//已释放的树,供setTerminals重用
+
+	//入边索引(CSR格式),结点v的入边为下标inOffset[v] ~ inOffset[v+1]-1
+	//inFrom为入边的起点,inSlot为入边在关联矩阵中的存储位置,权值从关联矩阵读取
+	vector<size_t> inOffset;
+	vector<IndexType> inFrom;
+	vector<size_t> inSlot;
+	size_t layout;						//入边索引对应的graph.layoutVersion
+
+	void buildInEdges()
+	{
+		size_t n = graph.graph.rows();
+		inOffset.assign(n + 1, 0);
+		for (Index u = 0; u < static_cast<Index>(n); u++)
+			for (EdgeIterator it(graph.graph, u); it; ++it)
+				inOffset[it.index() + 1]++;
+		for (size_t v = 0; v < n; v++)
+			inOffset[v + 1] += inOffset[v];
+		inFrom.resize(inOffset[n]);
+		inSlot.resize(inOffset[n]);
+		vector<size_t> pos(inOffset.begin(), inOffset.end() - 1);
+		for (Index u = 0; u < static_cast<Index>(n); u++)
+			for (EdgeIterator it(graph.graph, u); it; ++it)
+			{
+				size_t i = pos[it.index()]++;
+				inFrom[i] = static_cast<IndexType>(u);
+				inSlot[i] = graph.edgeIndex(it);
+			}
+		layout = graph.layoutVersion;
+	}
+
+	//遍历x的出边(outgoing为true)或入边的另一端点f(y, 权值),跳过已删除的边
+	template <typename Func>
+	void forEachNeighbor(IndexType x, bool outgoing, Func f) const
+	{
+		if (outgoing)
+		{
+			for (EdgeIterator it(graph.graph, x); it; ++it)
+				if (it.value() != 0)
+					f(static_cast<IndexType>(it.index()), it.value());
+		}
+		else
+			for (size_t i = inOffset[x]; i < inOffset[x + 1]; i++)
+				if (graph.graph.valuePtr()[inSlot[i]] != 0)
+					f(inFrom[i], graph.graph.valuePtr()[inSlot[i]]);
+	}
+
+	//沿树的方向遍历x的邻居: 正向树为出边,反向树为入边
+	template <typename Func>
+	void forEachForward(const Tree &t, IndexType x, Func f) const
+	{
+		forEachNeighbor(x, !t.toRoot, f);
+	}
+
+	//逆着树的方向遍历x的邻居
+	template <typename Func>
+	void forEachBackward(const Tree &t, IndexType x, Func f) const
+	{
+		forEachNeighbor(x, t.toRoot, f);
+	}
+
+	//从堆中的结点开始向后传播距离,返回出堆的结点数
+	size_t propagate(Tree &t, Heap &heap)
+	{
+		size_t settled = 0;
+		while (!heap.empty())
+		{
+			HeapItem top = heap.top();
+			heap.pop();
+			IndexType x = top.second;
+			if (top.first > t.dist[x])
+				continue;
+			settled++;
+			forEachForward(t, x, [&](IndexType y, ValueType w)
+			{
+				if (top.first + w < t.dist[y])
+				{
+					t.dist[y] = top.first + w;
+					t.parent[y] = x;
+					heap.push(HeapItem(t.dist[y], y));
+				}
+			});
+		}
+		return settled;
+	}
+
+	//完整计算一棵树
+	void compute(Tree &t)
+	{
+		size_t n = graph.graph.rows();
+		t.dist.assign(n, unreached);
+		t.parent.assign(n, npos);
+		t.affected.assign(n, false);
+		Heap heap;
+		t.dist[t.root] = 0;
+		heap.push(HeapItem(0, t.root));
+		propagate(t, heap);
+	}
+
+	/*
+	 * @function name : repair
+	 * @description : 有向图修改后增量修复一棵树
+	 * @inparam : t 修改前正确的最短路径树
+	 * @inparam : changes 边的修改(内部编号)
+	 */
+	void repair(Tree &t, const vector<EdgeChange<ValueType, IndexType>> &changes)
+	{
+		size_t n = graph.graph.rows();
+		//新结点不可达
+		t.dist.resize(n, unreached);
+		t.parent.resize(n, npos);
+		t.affected.resize(n, false);
+		vector<IndexType> affected;
+		//1. 权值变大或被删除的树边,标记其子树
+		for (auto &change : changes)
+		{
+			IndexType a = t.toRoot ? change.to : change.from;
+			IndexType b = t.toRoot ? change.from : change.to;
+			bool worse = change.oldWeight != 0 && (change.newWeight == 0 || change.newWeight > change.oldWeight);
+			if (!worse || t.parent[b] != a || t.affected[b])
+				continue;
+			size_t head = affected.size();
+			t.affected[b] = true;
+			affected.push_back(b);
+			//affected本身作为队列使用;被删除的树边不会被遍历到,但它们本身也在changes中
+			for (; head < affected.size(); head++)
+			{
+				IndexType x = affected[head];
+				forEachForward(t, x, [&](IndexType y, ValueType)
+				{
+					if (t.parent[y] == x && !t.affected[y])
+					{
+						t.affected[y] = true;
+						affected.push_back(y);
+					}
+				});
+			}
+		}
+		for (IndexType x : affected)
+		{
+			t.dist[x] = unreached;
+			t.parent[x] = npos;
+		}
+		Heap heap;
+		//由不受影响的前驱结点确定初始距离
+		for (IndexType x : affected)
+		{
+			forEachBackward(t, x, [&](IndexType y, ValueType w)
+			{
+				if (!t.affected[y] && t.dist[y] != unreached && t.dist[y] + w < t.dist[x])
+				{
+					t.dist[x] = t.dist[y] + w;
+					t.parent[x] = y;
+				}
+			});
+			if (t.dist[x] != unreached)
+				heap.push(HeapItem(t.dist[x], x));
+		}
+		//2. 权值变小或新插入的边
+		for (auto &change : changes)
+		{
+			IndexType a = t.toRoot ? change.to : change.from;
+			IndexType b = t.toRoot ? change.from : change.to;
+			bool better = change.newWeight != 0 && (change.oldWeight == 0 || change.newWeight < change.oldWeight);
+			if (better && t.dist[a] != unreached && t.dist[a] + change.newWeight < t.dist[b])
+			{
+				t.dist[b] = t.dist[a] + change.newWeight;
+				t.parent[b] = a;
+				heap.push(HeapItem(t.dist[b], b));
+			}
+		}
+		for (IndexType x : affected)
+			t.affected[x] = false;
+		//3. 向后传播
+		size_t settled = propagate(t, heap);
+		PROFILE_COUNT("DynamicShortestPaths.affected", affected.size());
+		PROFILE_COUNT("DynamicShortestPaths.settled", settled);
+	}
+
+public:
+	explicit DynamicShortestPaths(Graph<ValueType, IndexType> &_graph)
+		: graph(_graph), layout(0)
+	{
+		buildInEdges();
+	}
+
+	/*
+	 * @function name : addTree
+	 * @description : 计算并维护一棵最短路径树
+	 * @inparam : root 根结点(输入编号)
+	 * @inparam : toRoot 为false时维护root到各结点的最短路径,为true时维护各结点到root的最短路径
+	 * @return : 树的编号,用于distance和path
+	 */
+	size_t addTree(IndexType root, bool toRoot = false)
+	{
+		PROFILE_SCOPE("DynamicShortestPaths::addTree");
+		if (!graph.contains(root))
+			throw out_of_range("根结点不存在");
+		Tree t;
+		t.root = graph.inner(root);
+		t.toRoot = toRoot;
+		compute(t);
+		trees.push_back(move(t));
+		return trees.size() - 1;
+	}
+
+	/*
+	 * @function name : setTerminals
+	 * @description : 维护终点两两之间的最短距离,每个终点维护一棵正向最短路径树
+	 *                重新设置时重用之前终点的树,多余的树被释放,不再修复;addTree得到的树不受影响
+	 * @inparam : _terminals 终点(输入编号),可以重复
+	 */
+	void setTerminals(const vector<IndexType> &_terminals)
+	{
+		for (IndexType v : _terminals)
+			if (!graph.contains(v))
+				throw out_of_range("终点不存在");
+		freeTrees.insert(freeTrees.end(), terminalTrees.begin(), terminalTrees.end());
+		terminals = _terminals;
+		terminalTrees.clear();
+		for (IndexType v : terminals)
+		{
+			if (freeTrees.empty())
+			{
+				terminalTrees.push_back(addTree(v));
+				continue;
+			}
+			Tree &t = trees[freeTrees.back()];
+			t.root = graph.inner(v);
+			t.toRoot = false;
+			compute(t);
+			terminalTrees.push_back(freeTrees.back());
+			freeTrees.pop_back();
+		}
+		for (size_t i : freeTrees)
+			trees[i] = Tree{ npos, false, {}, {}, {} };
+	}
+
+	//第i个终点到第j个终点的最短距离
+	ValueType terminalDistance(size_t i, size_t j) const
+	{
+		return distance(terminalTrees[i], terminals[j]);
+	}
+
+	//树tree中根结点与v(输入编号)之间的最短距离,不可达时为ValueType的最大值
+	ValueType distance(size_t tree, IndexType v) const
+	{
+		const Tree &t = trees[tree];
+		if (!graph.contains(v) || static_cast<size_t>(graph.inner(v)) >= t.dist.size())
+			return unreached;
+		return t.dist[graph.inner(v)];
+	}
+
+	/*
+	 * @function name : path
+	 * @description : 从树中取出根结点与v之间的最短路径
+	 * @outparam : edges 路径(输入编号),正向树为root->v,反向树为v->root
+	 * @return : 路径的长度
+	 */
+	ValueType path(size_t tree, IndexType v, vector<IndexType> &edges) const
+	{
+		const Tree &t = trees[tree];
+		ValueType d = distance(tree, v);
+		edges.clear();
+		if (d == unreached)
+			return d;
+		for (IndexType x = graph.inner(v); x != npos; x = t.parent[x])
+			edges.push_back(graph.outer(x));
+		if (!t.toRoot)
+			reverse(edges.begin(), edges.end());
+		return d;
+	}
+
+	/*
+	 * @function name : update
+	 * @description : 批量修改有向图的边(见Graph::update),并增量修复所有最短路径树和终点距离表
+	 * @inparam : batch 边及其新权值(输入编号),权值为0表示删除
+	 * @return : 实际发生的修改(输入编号)
+	 */
+	vector<EdgeChange<ValueType, IndexType>> update(const vector<pair<LineType, ValueType>> &batch)
+	{
+		PROFILE_SCOPE("DynamicShortestPaths::update");
+		vector<EdgeChange<ValueType, IndexType>> changes = graph.update(batch);
+		if (layout != graph.layoutVersion)
+			buildInEdges();
+		vector<EdgeChange<ValueType, IndexType>> innerChanges = changes;
+		for (auto &change : innerChanges)
+		{
+			change.from = graph.inner(change.from);
+			change.to = graph.inner(change.to);
+		}
+#pragma omp parallel for schedule(dynamic)
+		for (int i = 0; i < static_cast<int>(trees.size()); i++)
+			if (trees[i].root != npos)
+				repair(trees[i], innerChanges);
+		return changes;
+	}
+};
+
+#endif // _DYNAMIC_PATHS_H_
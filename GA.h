@@ -1,22 +1,42 @@
 ﻿#pragma once
 #include "stdafx.h"
 #include "Graph.h"
+#include "KShortestPaths.h"
 
 constexpr double inf = numeric_limits<double>::max();
 
-template <typename T>
+template <typename T, typename IndexType = int>
 struct NodeInfo
 {
-	int index;		//当前结点的index
-	bool isPassed;	//当前结点是否已经经过
-	bool isLine;	//是否为线段
-	int reIdx;		//如果为线段,则存储线段的另一个端点的index
-	T weight;		//如果为线段,则存储线段的权重
-	NodeInfo(int _index, bool _isLine = false, int _reIdx = -1, T _weight = inf)
+	IndexType index;	//当前结点的index
+	bool isPassed;		//当前结点是否已经经过
+	bool isLine;		//是否为线段
+	IndexType reIdx;	//如果为线段,则存储线段的另一个端点的index
+	T weight;			//如果为线段,则存储线段的权重
+	NodeInfo(IndexType _index, bool _isLine = false,
+		IndexType _reIdx = static_cast<IndexType>(-1), T _weight = numeric_limits<T>::max())
 		:index(_index), isPassed(false),
 		isLine(_isLine), reIdx(_reIdx), weight(_weight) {}
 };
 
+//必经线段在vecN中以相邻的两项存储(两个方向),返回与第j项配对的另一项
+//线段起点的编号可以大于终点,顶点重新编号后大小关系也可能改变,因此按端点判断而非比较编号大小
+template <typename T, typename IndexType>
+size_t pairedLine(const vector<NodeInfo<T, IndexType>> &vecN, size_t j)
+{
+	if (j + 1 < vecN.size() && vecN[j + 1].isLine &&
+		vecN[j + 1].index == vecN[j].reIdx && vecN[j + 1].reIdx == vecN[j].index)
+		return j + 1;
+	return j - 1;
+}
+
+/*
+ * 遗传算法
+ * ValueType为有向图权值的类型,IndexType为顶点编号的类型,与Graph的模板参数相同
+ * 每个个体的路径以IndexType存储,较小的编号类型可减小种群的内存占用
+ * 保存graph和mask的引用,多个GA可共用一个Graph,使用期间graph和mask不能被销毁或修改
+ */
+template <typename ValueType = double, typename IndexType = int>
 class GA
 {
 private:
@@ -24,87 +44,483 @@ private:
 	size_t GA_POPSIZE;
 	size_t GA_MAXITER;
 	const double GA_ELITRATE = 0.1;	//交叉互换过程中保留的最适种群比例
-	int START, END;
-	Graph<double> graph;
-	vector<NodeInfo<double>> vecN;
+	IndexType START, END;
+	const Graph<ValueType, IndexType> &graph;
+	const ForbiddenMask<ValueType, IndexType> *mask;	//不能经过的结点和边,在查询边时检查
+	vector<NodeInfo<ValueType, IndexType>> vecN;
 	struct GA_struct
 	{
-		vector<int> path;
+		vector<IndexType> path;
 		double fitness;
+		bool refined = false;	//是否已完成局部搜索(已是局部最优),精英个体保留到下一代时不再重复搜索
 	};
+	const size_t GA_LSWINDOW = 6;	//局部搜索替换的子路径最多包含的边数
+	bool localSearch;				//是否对精英个体进行局部搜索,由Solve设置
+	const double GA_SEEDRATE = 0.5;	//初始种群中由k最短路径生成的个体比例,其余个体由随机游走生成
+	bool seedPaths;					//是否用k最短路径生成初始个体,由Solve设置
+
+	//提前终止求解的条件,由Solve设置,OpenMP各线程通过stopFlag协同退出
+	chrono::steady_clock::time_point deadline;
+	size_t maxEvaluations;
+	atomic<bool> stopFlag;
+	atomic<size_t> evaluations;		//已计算适应度的次数
 
-	void CalFitness(GA_struct &citizen)
+	//边u->v(内部编号)的权值,边不存在,被屏蔽或与被屏蔽的结点相连时为0
+	//未屏蔽任何边时不必查找边的存储位置
+	ValueType weight(IndexType u, IndexType v) const
+	{
+		ValueType w = graph.graph.coeff(u, v);
+		if (w == 0 || !mask)
+			return w;
+		if (mask->vertex(u) || mask->vertex(v))
+			return 0;
+		return mask->forbiddenLines().empty() || !mask->edge(graph.edgeIndex(u, v)) ? w : 0;
+	}
+
+	//判断是否应提前终止,到达截止时间,计算次数用完或被requestStop后返回true
+	bool shouldStop()
+	{
+		if (stopFlag.load(memory_order_relaxed))
+			return true;
+		if (chrono::steady_clock::now() >= deadline ||
+			(maxEvaluations && evaluations.load(memory_order_relaxed) >= maxEvaluations))
+			stopFlag.store(true, memory_order_relaxed);
+		return stopFlag.load(memory_order_relaxed);
+	}
+
+	//统计路径经过的必经结点和线段,isNPassed[j]表示是否经过vecN[j],返回经过的个数
+	size_t PassedItems(const vector<IndexType> &path, vector<bool> &isNPassed)
 	{
-		citizen.fitness = 0;
-		for (size_t i = 1; i < PATH_LENGTH; i++)
-			citizen.fitness += graph.graph.coeff(citizen.path[i - 1], citizen.path[i]);
 		size_t numN = 0;
-		vector<bool> isNPassed(vecN.size());
+		isNPassed.assign(vecN.size(), false);
 		for (size_t i = 0; i < PATH_LENGTH; i++)
 		{
 			for (size_t j = 0; j < vecN.size(); j++)
-				if (citizen.path[i] == vecN[j].index && !isNPassed[j])
+				if (path[i] == vecN[j].index && !isNPassed[j])
 				{
 					if (!vecN[j].isLine)
 					{
 						numN++;
 						isNPassed[j] = true;
 					}
-					else if (i < PATH_LENGTH - 1 && citizen.path[i + 1] == vecN[j].reIdx)
+					else if (i < PATH_LENGTH - 1 && path[i + 1] == vecN[j].reIdx)
 					{
 						numN++;
 						isNPassed[j] = true;
 						//相关联的线段端点也被认为已经过
-						if (vecN[j].reIdx > vecN[j].index)
-							isNPassed[j + 1] = true;
-						else
-							isNPassed[j - 1] = true;
+						isNPassed[pairedLine(vecN, j)] = true;
 					}
 				}
 		}
+		return numN;
+	}
+
+	//计算适应度,先占用一次计算次数;计算次数已用完时设置stopFlag并返回false,citizen不变
+	//占用以比较交换完成,OpenMP各线程并行调用时也不会超出上限
+	bool CalFitness(GA_struct &citizen)
+	{
+		size_t used = evaluations.load(memory_order_relaxed);
+		do
+		{
+			if (maxEvaluations && used >= maxEvaluations)
+			{
+				stopFlag.store(true, memory_order_relaxed);
+				return false;
+			}
+		} while (!evaluations.compare_exchange_weak(used, used + 1, memory_order_relaxed));
+		citizen.fitness = 0;
+		for (size_t i = 1; i < PATH_LENGTH; i++)
+			citizen.fitness += graph.graph.coeff(citizen.path[i - 1], citizen.path[i]);
+		vector<bool> isNPassed;
+		size_t numN = PassedItems(citizen.path, isNPassed);
 		citizen.fitness = citizen.fitness * (1 << (4 - numN));
+		return true;
 	}
 
-	void InitPopulation(vector<GA_struct> &population)
+	//BestSubpath的工作区,状态编号为 结点*2+是否已经过item, (层l,状态s)的键为 s*(GA_LSWINDOW+1)+l
+	//只存储可达的状态,第l层的状态为下标begin[l] ~ begin[l+1]-1的元素,内存只与窗口内可达的状态数有关,与有向图的规模无关
+	//键到下标的映射为线性探测的开放定址哈希表,容量为2的幂;每次动态规划开始时只复位上一次用过的槽
+	struct SubpathWorkspace
 	{
-		population.resize(GA_POPSIZE);
-#pragma omp parallel for
-		for (int i = 0; i < GA_POPSIZE; i++)
+		vector<size_t> key;
+		vector<ValueType> cost;
+		vector<size_t> pred;		//前驱的下标
+		vector<size_t> slot;		//在table中的位置,用于复位
+		vector<size_t> begin;
+		vector<size_t> table;		//下标+1,0表示空槽
+
+		//键k所在的槽或应插入的空槽
+		size_t probe(size_t k) const
+		{
+			size_t mask = table.size() - 1;
+			size_t h = static_cast<size_t>((static_cast<uint64_t>(k) * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+			while (table[h] != 0 && key[table[h] - 1] != k)
+				h = (h + 1) & mask;
+			return h;
+		}
+
+		//键k的下标,不存在时插入,代价为unreached
+		size_t locate(size_t k, ValueType unreached)
+		{
+			//装载率不超过1/2
+			if (2 * (key.size() + 1) > table.size())
+			{
+				table.assign(max<size_t>(64, 2 * table.size()), 0);
+				for (size_t i = 0; i < key.size(); i++)
+				{
+					slot[i] = probe(key[i]);
+					table[slot[i]] = i + 1;
+				}
+			}
+			size_t h = probe(k);
+			if (table[h] != 0)
+				return table[h] - 1;
+			table[h] = key.size() + 1;
+			slot.push_back(h);
+			key.push_back(k);
+			cost.push_back(unreached);
+			pred.push_back(0);
+			return key.size() - 1;
+		}
+
+		void reset()
+		{
+			for (size_t h : slot)
+				table[h] = 0;
+			key.clear();
+			cost.clear();
+			pred.clear();
+			slot.clear();
+			begin.clear();
+		}
+	};
+	vector<SubpathWorkspace> workspaces;	//每个OpenMP线程一个,在所有代及多次Solve之间复用
+
+	/*
+	 * @function name : BestSubpath
+	 * @description : 按边数分层动态规划,求from->to恰好hops条边的最短路径
+	 *                只用于局部搜索的小窗口,每层只遍历可达的状态;与随机游走相同,中间结点不能为START
+	 * @inparam : from, to 子路径的首尾结点(内部编号)
+	 * @inparam : hops 子路径的边数,不超过GA_LSWINDOW
+	 * @inparam : item 非负时要求子路径经过vecN[item](结点,或线段的任一方向)
+	 * @inparam : sub 输出的子路径,共hops+1个结点
+	 * @return : 是否存在满足条件的子路径
+	 */
+	bool BestSubpath(IndexType from, IndexType to, size_t hops, int item,
+		vector<IndexType> &sub, SubpathWorkspace &ws)
+	{
+		typedef typename Graph<ValueType, IndexType>::EdgeIterator EdgeIterator;
+		const ValueType unreached = numeric_limits<ValueType>::max();
+		//经过边u->v后是否经过了item
+		auto covers = [&](IndexType u, IndexType v)
+		{
+			if (item < 0)
+				return false;
+			const auto &node = vecN[item];
+			if (!node.isLine)
+				return v == node.index;
+			return (u == node.index && v == node.reIdx) || (u == node.reIdx && v == node.index);
+		};
+		size_t first = static_cast<size_t>(from) * 2 +
+			(item >= 0 && !vecN[item].isLine && from == vecN[item].index);
+		const size_t layers = GA_LSWINDOW + 1;
+		ws.reset();
+		ws.begin.push_back(0);
+		ws.cost[ws.locate(first * layers, unreached)] = 0;
+		for (size_t l = 0; l < hops; l++)
+		{
+			size_t end = ws.key.size();
+			ws.begin.push_back(end);
+			for (size_t i = ws.begin[l]; i < end; i++)
+			{
+				size_t state = ws.key[i] / layers;
+				IndexType u = static_cast<IndexType>(state / 2);
+				ValueType cost = ws.cost[i];
+				for (EdgeIterator it(graph.graph, u); it; ++it)
+				{
+					IndexType v = static_cast<IndexType>(it.col());
+					//最后一层只保留终点
+					if (it.value() == 0 || v == START || (l + 1 == hops) != (v == to) ||
+						(mask && (mask->vertex(v) || mask->edge(graph.edgeIndex(it)))))
+						continue;
+					size_t next = static_cast<size_t>(v) * 2 + (state % 2 || covers(u, v));
+					size_t pos = ws.locate(next * layers + l + 1, unreached);
+					if (cost + it.value() < ws.cost[pos])
+					{
+						ws.cost[pos] = cost + it.value();
+						ws.pred[pos] = i;
+					}
+				}
+			}
+		}
+		//不要求经过item时状态只有"未经过"一种
+		size_t last = ws.table[ws.probe((static_cast<size_t>(to) * 2 + (item >= 0)) * layers + hops)];
+		if (last == 0)
+			return false;
+		sub.resize(hops + 1);
+		for (size_t l = hops, pos = last - 1; l > 0; l--)
+		{
+			sub[l] = static_cast<IndexType>(ws.key[pos] / layers / 2);
+			pos = ws.pred[pos];
+		}
+		sub[0] = from;
+		return true;
+	}
+
+	/*
+	 * @function name : LocalSearch
+	 * @description : 对一个个体进行局部搜索,直到不能再改进
+	 *                1. 对每个未经过的必经结点/线段,尝试将长度不超过GA_LSWINDOW的子路径替换为经过它的最短子路径
+	 *                2. 将每个长度不超过GA_LSWINDOW的子路径替换为边数相同的最短子路径
+	 *                替换后适应度更小时接受;路径长度不变,因此替换后仍是合法的个体
+	 * @inparam : citizen 精英个体,path非空
+	 * @inparam : ws 当前线程的工作区
+	 */
+	void LocalSearch(GA_struct &citizen, SubpathWorkspace &ws)
+	{
+		size_t windows = 0, improvements = 0;	//动态规划的次数,接受的替换次数
+		size_t maxWindow = min(GA_LSWINDOW, PATH_LENGTH - 1);
+		GA_struct candidate;
+		vector<IndexType> sub;
+		vector<bool> isNPassed;
+		bool improved = true, stopped = false;
+		//尝试用sub替换citizen.path[a ~ a+hops],适应度更小时接受;计算次数用完时立即终止搜索
+		auto tryReplace = [&](size_t a)
+		{
+			candidate.path = citizen.path;
+			copy(sub.begin(), sub.end(), candidate.path.begin() + a);
+			if (!CalFitness(candidate))
+			{
+				stopped = true;
+				return false;
+			}
+			if (candidate.fitness >= citizen.fitness)
+				return false;
+			citizen.path.swap(candidate.path);
+			citizen.fitness = candidate.fitness;
+			improvements++;
+			return true;
+		};
+		while (improved && !stopped)
+		{
+			improved = false;
+			PassedItems(citizen.path, isNPassed);
+			for (size_t j = 0; j < vecN.size() && !improved && !stopped; j++)
+			{
+				//线段的两个方向任选其一即可
+				if (isNPassed[j] || (vecN[j].isLine && pairedLine(vecN, j) < j))
+					continue;
+				for (size_t hops = 2; hops <= maxWindow && !improved && !stopped; hops++)
+					for (size_t a = 0; a + hops < PATH_LENGTH && !improved && !stopped; a++)
+					{
+						if ((stopped = shouldStop()))
+							break;
+						windows++;
+						if (BestSubpath(citizen.path[a], citizen.path[a + hops], hops, static_cast<int>(j), sub, ws))
+							improved = tryReplace(a);
+					}
+			}
+			for (size_t hops = 2; hops <= maxWindow && !improved && !stopped; hops++)
+				for (size_t a = 0; a + hops < PATH_LENGTH && !improved && !stopped; a++)
+				{
+					if ((stopped = shouldStop()))
+						break;
+					windows++;
+					if (!BestSubpath(citizen.path[a], citizen.path[a + hops], hops, -1, sub, ws))
+						continue;
+					//子路径的代价不变时不必计算适应度
+					ValueType oldCost = 0, newCost = 0;
+					for (size_t k = 0; k < hops; k++)
+					{
+						oldCost += graph.graph.coeff(citizen.path[a + k], citizen.path[a + k + 1]);
+						newCost += graph.graph.coeff(sub[k], sub[k + 1]);
+					}
+					if (newCost < oldCost)
+						improved = tryReplace(a);
+				}
+		}
+		citizen.refined = !stopped;
+		PROFILE_COUNT("GA::LocalSearch.windows", windows);
+		PROFILE_COUNT("GA::LocalSearch.improvements", improvements);
+	}
+
+	//并行地对尚未完成局部搜索的精英个体进行局部搜索,population已按适应度排序
+	void RefineElites(vector<GA_struct> &population)
+	{
+		PROFILE_SCOPE("GA::LocalSearch");
+		int esize = static_cast<int>(GA_POPSIZE * GA_ELITRATE);
+		//交叉互换常产生与精英相同的个体,相同的路径只搜索一次
+		map<vector<IndexType>, int> first;
+		vector<int> same(esize), todo;
+		for (int i = 0; i < esize; i++)
+		{
+			if (population[i].path.empty())
+				continue;
+			auto found = first.find(population[i].path);
+			if (found != first.end() && !population[found->second].refined)
+				same[i] = found->second;
+			else
+			{
+				same[i] = i;
+				if (found == first.end())
+					first[population[i].path] = i;
+				if (!population[i].refined)
+					todo.push_back(i);
+			}
+		}
+		//各个体的搜索量差别较大,动态分配
+#pragma omp parallel for schedule(dynamic)
+		for (int k = 0; k < static_cast<int>(todo.size()); k++)
+		{
+#ifdef _OPENMP
+			SubpathWorkspace &ws = workspaces[omp_get_thread_num()];
+#else
+			SubpathWorkspace &ws = workspaces[0];
+#endif
+			LocalSearch(population[todo[k]], ws);
+		}
+		for (int i = 0; i < esize; i++)
+			if (same[i] != i && !population[i].path.empty())
+				population[i] = population[same[i]];
+		sort(population.begin(), population.begin() + esize, [](GA_struct &x, GA_struct &y)
+		{
+			return x.fitness < y.fitness;
+		});
+	}
+
+	/*
+	 * 从START出发随机游走PATH_LENGTH-1步,直到恰好在最后一步到达END
+	 * 每选取1024次结点检查一次是否应提前终止
+	 * 返回false表示提前终止,path无效
+	 */
+	bool RandomWalk(vector<IndexType> &path, size_t &walks, size_t &draws)
+	{
+		path.resize(PATH_LENGTH);
+		int n = static_cast<int>(graph.graph.rows());
+		IndexType col;
+		do
 		{
+			walks++;
+			if (shouldStop())
+				return false;
+			//生成起点->第1个结点
 			do
 			{
-				population[i].path.resize(PATH_LENGTH);
-				int n = graph.graph.rows();
-				int col;
-				//生成起点->第1个结点
+				if ((++draws & 1023) == 0 && shouldStop())
+					return false;
+				col = static_cast<IndexType>(rand() % n);
+			} while (weight(START, col) == 0 || col == START || col == END);
+			path[0] = START;
+			path[1] = col;
+			//生成中间的结点
+			for (size_t j = 2; j < PATH_LENGTH; j++)
+			{
 				do
 				{
-					col = rand() % n;
-				} while (graph.graph.coeff(START, col) == 0 || col == START || col == END);
-				population[i].path[0] = START;
-				population[i].path[1] = col;
-				//生成中间的结点
-				for (size_t j = 2; j < PATH_LENGTH; j++)
+					if ((++draws & 1023) == 0 && shouldStop())
+						return false;
+					col = static_cast<IndexType>(rand() % n);
+				} while (weight(path[j - 1], col) == 0 || col == START);
+				path[j] = col;
+			}
+		} while (path[PATH_LENGTH - 1] != END);
+		return true;
+	}
+
+	/*
+	 * @function name : SeedPopulation
+	 * @description : 按代价从小到大取START->END的简单路径作为初始个体
+	 *                边数不足PATH_LENGTH-1的路径在往返代价最小的一条边上往返补足,补足的边数须为偶数
+	 *                最多检查个体数4倍的路径
+	 * @inparam : population 从population[0]开始存放生成的个体
+	 * @return : 生成的个体数,最多为GA_POPSIZE*GA_SEEDRATE
+	 */
+	size_t SeedPopulation(vector<GA_struct> &population)
+	{
+		PROFILE_SCOPE("GA::SeedPopulation");
+		size_t maxSeeds = static_cast<size_t>(GA_POPSIZE * GA_SEEDRATE), seeds = 0;
+		if (maxSeeds == 0 || START == END)
+			return 0;
+		KShortestPaths<ValueType, IndexType> ksp(graph, graph.outer(START), graph.outer(END),
+			0, numeric_limits<size_t>::max(), mask);
+		vector<IndexType> path;
+		ValueType cost;
+		while (seeds < maxSeeds && ksp.count() < 4 * maxSeeds && !shouldStop() && ksp.next(path, cost))
+		{
+			size_t hops = path.size() - 1;
+			if (hops > PATH_LENGTH - 1 || (PATH_LENGTH - 1 - hops) % 2)
+				continue;
+			for (auto &v : path)
+				v = graph.inner(v);
+			//选取往返代价最小的边path[best]<->path[best+1],起点不能再次出现,因此best从1开始
+			size_t rounds = (PATH_LENGTH - 1 - hops) / 2, best = 0;
+			ValueType bestCost = numeric_limits<ValueType>::max();
+			for (size_t i = 1; rounds && i < hops; i++)
+			{
+				ValueType back = weight(path[i + 1], path[i]);
+				if (back != 0 && graph.graph.coeff(path[i], path[i + 1]) + back < bestCost)
 				{
-					do
-					{
-						col = rand() % n;
-					} while (graph.graph.coeff(population[i].path[j - 1], col) == 0 || col == START);
-					population[i].path[j] = col;
+					bestCost = graph.graph.coeff(path[i], path[i + 1]) + back;
+					best = i;
 				}
-			} while (population[i].path[PATH_LENGTH - 1] != END);
-			CalFitness(population[i]);
+			}
+			if (rounds && best == 0)
+				continue;
+			GA_struct &citizen = population[seeds++];
+			citizen.path.clear();
+			for (size_t i = 0; i <= hops; i++)
+			{
+				citizen.path.push_back(path[i]);
+				if (i == best)
+					for (size_t r = 0; r < rounds; r++)
+					{
+						citizen.path.push_back(path[i + 1]);
+						citizen.path.push_back(path[i]);
+					}
+			}
+			if (!CalFitness(citizen))
+			{
+				citizen.path.clear();
+				seeds--;
+				break;
+			}
+		}
+		PROFILE_COUNT("GA::SeedPopulation.paths", ksp.count());
+		PROFILE_COUNT("GA::SeedPopulation.seeds", seeds);
+		return seeds;
+	}
+
+	//生成初始种群,提前终止时未生成的个体path为空,fitness为inf
+	void InitPopulation(vector<GA_struct> &population)
+	{
+		PROFILE_SCOPE("GA::InitPopulation");
+		population.resize(GA_POPSIZE);
+		int seeds = seedPaths ? static_cast<int>(SeedPopulation(population)) : 0;
+#pragma omp parallel for
+		for (int i = seeds; i < GA_POPSIZE; i++)
+		{
+			size_t walks = 0, draws = 0;	//随机游走次数,随机选取结点的次数
+			bool valid = RandomWalk(population[i].path, walks, draws);
+			PROFILE_COUNT("GA::InitPopulation.walks", walks);
+			PROFILE_COUNT("GA::InitPopulation.draws", draws);
+			//计算次数在生成初始种群时用完,其余个体不再生成
+			if (!valid || !CalFitness(population[i]))
+			{
+				population[i].path.clear();
+				population[i].fitness = inf;
+			}
 		}
 
 	}
 
-	bool isNotConnected(int i1, int i2)
+	bool isNotConnected(IndexType i1, IndexType i2)
 	{
-		return graph.graph.coeff(i1, i2) == 0;
+		return weight(i1, i2) == 0;
 	}
 
 	void Mate(vector<GA_struct> &population)
 	{
+		PROFILE_SCOPE("GA::Mate");
 		size_t esize = GA_POPSIZE * GA_ELITRATE;
 		vector<GA_struct> buffer(population.size());
 		for (auto &item : buffer)
@@ -115,8 +531,16 @@ private:
 		for (int i = esize; i < GA_POPSIZE; i++)
 		{
 			size_t j, start, end;
+			size_t tries = 0;	//选取交叉片段的次数
+			bool stopped = false;
 			do 
 			{
+				//提前终止时直接保留父代个体
+				if ((++tries & 1023) == 0 && shouldStop())
+				{
+					stopped = true;
+					break;
+				}
 				j = rand() % (GA_POPSIZE / 2);
 				start = rand() % PATH_LENGTH;
 				do
@@ -128,6 +552,12 @@ private:
 				(start != 0 && end == PATH_LENGTH - 1 && isNotConnected(population[i].path[start - 1], population[j].path[start])) ||
 				(start != 0 && end != PATH_LENGTH - 1 && (isNotConnected(population[i].path[start - 1], population[j].path[start]) || isNotConnected(population[i].path[end + 1], population[j].path[end])))
 			);
+			PROFILE_COUNT("GA::Mate.tries", tries);
+			if (stopped)
+			{
+				buffer[i] = population[i];
+				continue;
+			}
 			for (size_t k = 0; k < start; k++)
 				buffer[i].path[k] = population[i].path[k];	//0 ~ start-1
 			for (size_t k = start; k <= end; k++)
@@ -155,27 +585,125 @@ private:
 	}
 
 public:
-	vector<int> PrintBest()
+	//Solve的终止条件和回调
+	struct SolveOptions
+	{
+		//墙钟截止时间,默认不限
+		chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+		//适应度计算次数上限,0表示不限;每一代需要计算GA_POPSIZE次
+		size_t maxEvaluations = 0;
+		//找到更优的路径时调用,参数为路径(输入编号),适应度,当前代数;只在主线程中调用
+		function<void(const vector<IndexType> &, double, size_t)> onImprove;
+		//每一代是否对精英个体进行局部搜索(memetic算法)
+		bool localSearch = true;
+		//是否用k最短简单路径生成一部分初始个体
+		bool seedPaths = true;
+
+		//设置从现在起的时间限制
+		template <typename Rep, typename Period>
+		SolveOptions &timeout(chrono::duration<Rep, Period> limit)
+		{
+			deadline = chrono::steady_clock::now() + limit;
+			return *this;
+		}
+	};
+
+	//Solve的结果
+	struct SolveResult
+	{
+		vector<IndexType> path;		//最优路径(输入编号),初始种群未生成任何个体时为空
+		double fitness;				//最优路径的适应度,路径为空时为inf
+		size_t generations;			//完成的代数
+		size_t evaluations;			//计算适应度的次数
+		bool stopped;				//是否因截止时间,计算次数上限或requestStop提前终止
+	};
+
+	//请求提前终止正在进行的Solve,可在其他线程中调用
+	//在Solve开始前调用时,下一次Solve不生成任何个体,立即返回;Solve返回时清除该请求
+	void requestStop()
 	{
+		stopFlag.store(true, memory_order_relaxed);
+	}
+
+	/*
+	 * @function name : Solve
+	 * @description : 随时可终止的遗传算法,到达截止时间或计算次数上限后返回目前找到的最优路径
+	 *                未设置终止条件时与PrintBest相同,迭代GA_MAXITER代或最优值连续20代不变时结束
+	 * @inparam : options 终止条件和回调
+	 * @return : 最优路径及求解统计
+	 */
+	SolveResult Solve(const SolveOptions &options = SolveOptions())
+	{
+		PROFILE_SCOPE("GA::Solve");
+#ifdef ENABLE_PROFILING
+		auto begin = chrono::steady_clock::now();
+#endif
+		deadline = options.deadline;
+		maxEvaluations = options.maxEvaluations;
+		localSearch = options.localSearch;
+		seedPaths = options.seedPaths;
+		evaluations.store(0);
+#ifdef _OPENMP
+		workspaces.resize(max(workspaces.size(), static_cast<size_t>(omp_get_max_threads())));
+#else
+		workspaces.resize(1);
+#endif
+
+		SolveResult result;
+		result.fitness = inf;
+		result.generations = 0;
+		vector<IndexType> best;		//目前最优的路径(内部编号)
+		//更新目前最优的路径并调用回调
+		auto improve = [&](const GA_struct &citizen)
+		{
+			if (citizen.fitness >= result.fitness)
+				return;
+			result.fitness = citizen.fitness;
+			best = citizen.path;
+			if (options.onImprove)
+			{
+				vector<IndexType> path = best;
+				for (auto &v : path)
+					v = graph.outer(v);
+				options.onImprove(path, result.fitness, result.generations);
+			}
+		};
+
 		vector<GA_struct> population;
 		InitPopulation(population);
+		for (auto &citizen : population)
+			if (!citizen.path.empty())
+				improve(citizen);
 		list<double> preFitness;
-		for (size_t i = 0; i < GA_MAXITER; i++)
+		//提前终止(包括初始种群未能生成完整)后不再交叉互换
+		for (size_t i = 0; i < GA_MAXITER && !shouldStop(); i++)
 		{
+			//计算次数上限不足一代时终止
+			if (maxEvaluations && evaluations.load() + GA_POPSIZE > maxEvaluations)
+			{
+				stopFlag.store(true);
+				break;
+			}
 			Mate(population);
 			//计算适应度
 			double sum_fitness = 0;
-			for (auto &citizen : population)
 			{
-				CalFitness(citizen);
-				sum_fitness += citizen.fitness;
+				PROFILE_SCOPE("GA::CalFitness");
+				for (auto &citizen : population)
+				{
+					CalFitness(citizen);
+					sum_fitness += citizen.fitness;
+				}
 			}
 			//按适应度从小到大排序
 			sort(population.begin(), population.end(), [](GA_struct &x, GA_struct &y)
 			{
 				return x.fitness < y.fitness;
 			});
-			printf("第%zd次循环的最优值\t%lf\n", i, population[0].fitness);
+			if (localSearch)
+				RefineElites(population);
+			result.generations++;
+			improve(population[0]);
 			//判断是否达到迭代终止条件
 			if (preFitness.size() >= 20)
 			{
@@ -191,12 +719,48 @@ public:
 
 			preFitness.push_back(population[0].fitness);	
 		}
-		return population[0].path;
+		result.stopped = stopFlag.load();
+		result.evaluations = evaluations.load();
+		//在此清除而不是在开始时清除,Solve开始前到达的requestStop不会被忽略
+		stopFlag.store(false);
+		PROFILE_COUNT("GA::generations", result.generations);
+		PROFILE_COUNT("GA::evaluations", result.evaluations);
+#ifdef ENABLE_PROFILING
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+		PROFILE_GAUGE("GA::generations_per_sec", seconds > 0 ? result.generations / seconds : 0);
+		PROFILE_GAUGE("GA::best_fitness", result.fitness);
+#endif
+		//内部编号->输入编号
+		result.path = move(best);
+		for (auto &v : result.path)
+			v = graph.outer(v);
+		return result;
+	}
+
+	//不限时间求解,返回最优路径
+	vector<IndexType> PrintBest()
+	{
+		return Solve().path;
 	}
 
-	GA(Graph<double> &_graph, vector<NodeInfo<double>> &_vecN, int start = 0, int end = 17, size_t path_length = 12, size_t popsize = 655, size_t maxiter = 65536)
-		: graph(_graph), START(start), END(end), vecN(_vecN),
-		PATH_LENGTH(path_length), GA_POPSIZE(popsize), GA_MAXITER(maxiter) {}
+	GA(const Graph<ValueType, IndexType> &_graph, vector<NodeInfo<ValueType, IndexType>> &_vecN, IndexType start = 0, IndexType end = 17, size_t path_length = 12, size_t popsize = 655, size_t maxiter = 65536,
+		const ForbiddenMask<ValueType, IndexType> *_mask = nullptr)
+		: graph(_graph), mask(_mask && !_mask->empty() ? _mask : nullptr), START(start), END(end), vecN(_vecN),
+		PATH_LENGTH(path_length), GA_POPSIZE(popsize), GA_MAXITER(maxiter),
+		localSearch(true), seedPaths(true),
+		deadline(chrono::steady_clock::time_point::max()), maxEvaluations(0), stopFlag(false), evaluations(0)
+	{
+		//有向图内部可能对顶点重新编号,遗传算法全程使用内部编号
+		START = graph.inner(START);
+		END = graph.inner(END);
+		for (auto &node : vecN)
+		{
+			node.index = graph.inner(node.index);
+			if (node.isLine)
+				node.reIdx = graph.inner(node.reIdx);
+		}
+		assert(!mask || mask->current(graph));
+	}
 	//START: 起始结点, END: 终止结点, vecN: 必经结点和线段, PATH_LENGTH: 要求的步数（经过的总结点数）
-	//GA_POPSIZE: 种群大小, GA_MAXITER: 最大迭代次数
+	//GA_POPSIZE: 种群大小, GA_MAXITER: 最大迭代次数, mask: 不能经过的结点和边
 };
\ No newline at end of file
@@ -0,0 +1,203 @@
+﻿#ifndef _GENERATOR_H_		//防止头文件被重复包含
+#define _GENERATOR_H_
+
+#include "stdafx.h"
+#include "GA.h"
+
+/*
+ * 合成图生成器,用于性能测试
+ * 所有生成器均生成双向边,权值为[1,9]的整数,使用同一随机数种子可得到相同的图
+ * coords非空时输出顶点坐标,可用于VertexOrder::Hilbert重排序
+ */
+
+//在边集中加入双向边u<->v
+inline void addBothWays(vector<pair<Line, double>> &edges, int u, int v, mt19937 &rng)
+{
+	uniform_int_distribution<int> weight(1, 9);
+	double w = weight(rng);
+	edges.push_back({ { u, v }, w });
+	edges.push_back({ { v, u }, w });
+}
+
+//width×height的网格图,每个结点与上下左右的结点相连
+inline vector<pair<Line, double>> gridGraph(int width, int height, unsigned seed,
+	vector<Point> *coords = nullptr)
+{
+	mt19937 rng(seed);
+	vector<pair<Line, double>> edges;
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+		{
+			int v = y * width + x;
+			if (x + 1 < width)
+				addBothWays(edges, v, v + 1, rng);
+			if (y + 1 < height)
+				addBothWays(edges, v, v + width, rng);
+		}
+	if (coords)
+	{
+		coords->resize(width * height);
+		for (int v = 0; v < width * height; v++)
+			(*coords)[v] = Point(v % width, v / width);
+	}
+	return edges;
+}
+
+//随机几何图：n个结点均匀分布在单位正方形内,距离小于radius的结点相连
+inline vector<pair<Line, double>> randomGeometricGraph(int n, double radius, unsigned seed,
+	vector<Point> *coords = nullptr)
+{
+	mt19937 rng(seed);
+	uniform_real_distribution<double> unit(0, 1);
+	vector<Point> points(n);
+	for (auto &p : points)
+		p = Point(unit(rng), unit(rng));
+	//按边长为radius的网格分桶,只比较相邻桶内的结点
+	int cells = max(1, static_cast<int>(1 / radius));
+	vector<vector<int>> bucket(cells * cells);
+	auto cellOf = [&](double c) { return min(cells - 1, static_cast<int>(c * cells)); };
+	for (int v = 0; v < n; v++)
+		bucket[cellOf(points[v].second) * cells + cellOf(points[v].first)].push_back(v);
+	vector<pair<Line, double>> edges;
+	for (int u = 0; u < n; u++)
+	{
+		int cx = cellOf(points[u].first), cy = cellOf(points[u].second);
+		for (int y = max(0, cy - 1); y <= min(cells - 1, cy + 1); y++)
+			for (int x = max(0, cx - 1); x <= min(cells - 1, cx + 1); x++)
+				for (int v : bucket[y * cells + x])
+				{
+					double dx = points[u].first - points[v].first;
+					double dy = points[u].second - points[v].second;
+					if (u < v && dx * dx + dy * dy < radius * radius)
+						addBothWays(edges, u, v, rng);
+				}
+	}
+	if (coords)
+		*coords = move(points);
+	return edges;
+}
+
+//Erdős–Rényi图：n个结点,随机选取约avgDegree*n/2对不同的结点相连
+inline vector<pair<Line, double>> erdosRenyiGraph(int n, double avgDegree, unsigned seed)
+{
+	mt19937 rng(seed);
+	uniform_int_distribution<int> vertex(0, n - 1);
+	size_t m = static_cast<size_t>(avgDegree * n / 2);
+	set<Line> lines;
+	while (lines.size() < m && lines.size() < static_cast<size_t>(n) * (n - 1) / 2)
+	{
+		int u = vertex(rng), v = vertex(rng);
+		if (u != v)
+			lines.insert(Line(min(u, v), max(u, v)));
+	}
+	vector<pair<Line, double>> edges;
+	for (auto &line : lines)
+		addBothWays(edges, line.first, line.second, rng);
+	return edges;
+}
+
+//无标度图(Barabási–Albert模型)：每个新结点按度数比例连接到m个已有结点
+inline vector<pair<Line, double>> scaleFreeGraph(int n, int m, unsigned seed)
+{
+	mt19937 rng(seed);
+	vector<pair<Line, double>> edges;
+	vector<int> endpoints;	//每条边的两个端点,从中均匀抽样即按度数比例抽样
+	for (int u = 1; u <= m && u < n; u++)
+		for (int v = 0; v < u; v++)
+		{
+			addBothWays(edges, u, v, rng);
+			endpoints.push_back(u);
+			endpoints.push_back(v);
+		}
+	for (int u = m + 1; u < n; u++)
+	{
+		set<int> targets;
+		while (static_cast<int>(targets.size()) < m)
+			targets.insert(endpoints[uniform_int_distribution<size_t>(0, endpoints.size() - 1)(rng)]);
+		for (int v : targets)
+		{
+			addBothWays(edges, u, v, rng);
+			endpoints.push_back(u);
+			endpoints.push_back(v);
+		}
+	}
+	return edges;
+}
+
+/*
+ * @function name : randomGreens
+ * @description : 从边集中随机选取必经结点和必经线段,格式与loadXML的输出相同
+ * @inparam : edges 有向图的所有边
+ * @inparam : numNodes 必经结点数
+ * @inparam : numLines 必经线段数
+ * @inparam : exclude 不能作为必经结点的结点(一般为起点和终点)
+ * @return : 必经结点与必经线段
+ */
+inline vector<NodeInfo<double>> randomGreens(const vector<pair<Line, double>> &edges,
+	size_t numNodes, size_t numLines, const set<int> &exclude, unsigned seed)
+{
+	mt19937 rng(seed);
+	uniform_int_distribution<size_t> pick(0, edges.size() - 1);
+	set<int> used(exclude);
+	vector<NodeInfo<double>> greens;
+	for (size_t i = 0, tries = 0; i < numNodes && tries < 100 * edges.size(); tries++)
+	{
+		int v = edges[pick(rng)].first.first;
+		if (used.insert(v).second)
+		{
+			greens.push_back(NodeInfo<double>(v));
+			i++;
+		}
+	}
+	for (size_t i = 0, tries = 0; i < numLines && tries < 100 * edges.size(); tries++)
+	{
+		const auto &edge = edges[pick(rng)];
+		int vs = edge.first.first, ve = edge.first.second;
+		if (!used.count(vs) && !used.count(ve))
+		{
+			used.insert(vs);
+			used.insert(ve);
+			greens.push_back(NodeInfo<double>(vs, true, ve, edge.second));
+			greens.push_back(NodeInfo<double>(ve, true, vs, edge.second));
+			i++;
+		}
+	}
+	return greens;
+}
+
+/*
+ * @function name : removeRandomReds
+ * @description : 随机选取不经结点和不经线段并从边集中删除,与loadXML的处理方式相同
+ * @inparam : numNodes 不经结点数
+ * @inparam : numLines 不经线段数(双向删除)
+ * @inparam : exclude 不能作为不经结点的结点(起点,终点和必经结点)
+ */
+inline void removeRandomReds(vector<pair<Line, double>> &edges,
+	size_t numNodes, size_t numLines, const set<int> &exclude, unsigned seed)
+{
+	mt19937 rng(seed);
+	set<int> redNodes;
+	set<Line> redLines;
+	for (size_t tries = 0; redNodes.size() < numNodes && tries < 100 * edges.size(); tries++)
+	{
+		int v = edges[uniform_int_distribution<size_t>(0, edges.size() - 1)(rng)].first.first;
+		if (!exclude.count(v))
+			redNodes.insert(v);
+	}
+	for (size_t tries = 0; redLines.size() < 2 * numLines && tries < 100 * edges.size(); tries++)
+	{
+		Line line = edges[uniform_int_distribution<size_t>(0, edges.size() - 1)(rng)].first;
+		if (!exclude.count(line.first) && !exclude.count(line.second))
+		{
+			redLines.insert(line);
+			redLines.insert(Line(line.second, line.first));
+		}
+	}
+	edges.erase(remove_if(edges.begin(), edges.end(), [&](const pair<Line, double> &edge)
+	{
+		return redNodes.count(edge.first.first) || redNodes.count(edge.first.second) ||
+			redLines.count(edge.first);
+	}), edges.end());
+}
+
+#endif // _GENERATOR_H_
@@ -2,22 +2,125 @@
 #define _GRAPH_H_
 
 #include "stdafx.h"
+#include "VertexOrder.h"
+#include "Profiler.h"
 
 typedef pair<int, int> Line;
 
-//有向图类型
-template <typename ValueType>	//ValueType为有向图权值的类型,一般为int或double
+/*
+ * 按图的最大顶点数在编译期选择最小的顶点编号类型
+ * 编号类型的最大值保留为"无结点"标记,因此顶点数必须小于该最大值
+ * 应用举例：
+ * Graph<float, CompactIndex<60000>::type> graph(collection);	//使用uint16_t存储顶点编号
+ */
+template <size_t MaxVertices>
+struct CompactIndex
+{
+	typedef typename conditional<(MaxVertices < 0xFFFFull), uint16_t,
+		typename conditional<(MaxVertices < 0xFFFFFFFFull), uint32_t, uint64_t>::type>::type type;
+	static_assert(MaxVertices < numeric_limits<type>::max(), "顶点数超出了顶点编号类型的表示范围");
+};
+
+template <typename ValueType, typename IndexType>
+class GA;
+
+template <typename ValueType, typename IndexType>
+class KShortestPaths;
+
+template <typename ValueType, typename IndexType>
+class ForbiddenMask;
+
+template <typename ValueType, typename IndexType>
+class DynamicShortestPaths;
+
+template <typename ValueType, typename IndexType>
+class HopFront;
+
+template <typename ValueType, typename IndexType>
+class HopMatrix;
+
+//Graph::update返回的边的修改记录,权值为0表示边不存在
+template <typename ValueType, typename IndexType>
+struct EdgeChange
+{
+	IndexType from, to;
+	ValueType oldWeight, newWeight;
+};
+
+/*
+ * 有向图类型
+ * ValueType为有向图权值的类型,一般为float,double或int
+ * IndexType为顶点编号的类型,一般为int,uint16_t,uint32_t或uint64_t
+ * 较小的IndexType可以减小路径、前驱结点表等数组的内存占用
+ * 关联矩阵本身仍使用Eigen默认的int作为下标类型,因此顶点数不能超过int的表示范围
+ */
+template <typename ValueType, typename IndexType = int>
 class Graph
 {
+	static_assert(is_arithmetic<ValueType>::value, "ValueType必须为算术类型");
+	static_assert(is_integral<IndexType>::value, "IndexType必须为整数类型");
+
+public:
+	//以顶点编号表示的有向边
+	typedef pair<IndexType, IndexType> LineType;
+
+	//"无结点"标记,顶点数必须小于此值
+	static constexpr IndexType npos = numeric_limits<IndexType>::max();
+
 private:
 	//使用Eigen矩阵库的稀疏矩阵类型存储关联矩阵
-	SparseMatrix<ValueType> graph;
+	//EIGEN_DEFAULT_TO_ROW_MAJOR对稀疏矩阵无效,需显式指定行优先,使每个结点的出边连续存储
+	//关联矩阵按内部编号存储,构造时可对顶点重新编号以提升缓存局部性
+	SparseMatrix<ValueType, RowMajor> graph;
 
-	ValueType getEdgeValue(int vs, int ve) const
+	//遍历关联矩阵某一行(某结点的所有出边)的迭代器
+	//update删除的边保留存储位置,权值为0,遍历时需要跳过
+	typedef typename SparseMatrix<ValueType, RowMajor>::InnerIterator EdgeIterator;
+
+	//边的存储位置每改变一次加1,用于判断依赖存储位置的数据(如入边索引)是否需要重新建立
+	size_t layoutVersion = 0;
+
+	//内部编号与输入编号的相互映射,为空表示未重新编号
+	vector<IndexType> toInner;	//输入编号->内部编号
+	vector<IndexType> toOuter;	//内部编号->输入编号
+
+	//判断顶点v是否存在,负数转换为size_t后超出范围
+	bool contains(IndexType v) const
+	{
+		return static_cast<size_t>(v) < static_cast<size_t>(graph.rows());
+	}
+
+	//输入编号->内部编号,超出范围的编号原样返回,由调用者判断
+	IndexType inner(IndexType v) const
 	{
-		return this->operator()(vs, ve);
+		return (toInner.empty() || static_cast<size_t>(v) >= toInner.size()) ? v : toInner[v];
 	}
 
+	//内部编号->输入编号
+	IndexType outer(IndexType v) const
+	{
+		return (toOuter.empty() || static_cast<size_t>(v) >= toOuter.size()) ? v : toOuter[v];
+	}
+
+	//边在关联矩阵中的存储位置,作为ForbiddenMask中边的编号
+	size_t edgeIndex(const EdgeIterator &it) const
+	{
+		return static_cast<size_t>(&it.value() - graph.valuePtr());
+	}
+
+	//边u->v(内部编号)的存储位置,边不存在时返回size_t的最大值
+	size_t edgeIndex(IndexType u, IndexType v) const
+	{
+		for (EdgeIterator it(graph, u); it; ++it)
+			if (it.index() == static_cast<Index>(v))
+				return edgeIndex(it);
+		return numeric_limits<size_t>::max();
+	}
+
+	//使用边的集合构造关联矩阵,详见构造函数
+	template <typename Container>
+	void build(const Container &collection, VertexOrder order, const vector<Point> *coords);
+
 	/*
 	 * 定义无穷大为ValueType类型的数值最大值
 	 * int一般为2147483647, double一般为1.7×10e308
@@ -36,12 +139,16 @@ public:
 	 * std::vector<std::pair<Line,ValueType>>
 	 * std::list<std::pair<Line,ValueType>>
 	 * 等等
+	 * order为顶点重排序方式,coords为顶点坐标(仅VertexOrder::Hilbert使用)
+	 * 重排序后所有公有接口仍使用输入编号,内部编号对调用者透明
 	 */
 	template <typename Container>
-	Graph(const Container &collection);
+	Graph(const Container &collection,
+		VertexOrder order = VertexOrder::None, const vector<Point> *coords = nullptr);
 
 	//使用初始化列表构造
-	Graph(const initializer_list < pair<Line, ValueType> > &initializer);
+	Graph(const initializer_list < pair<LineType, ValueType> > &initializer,
+		VertexOrder order = VertexOrder::None, const vector<Point> *coords = nullptr);
 
 	//默认构造函数
 	Graph(size_t numVertexes)
@@ -51,23 +158,227 @@ public:
 
 	//重载<<运算符,向有向图中添加边
 	//返回当前对象的引用,用于对个<<运算符连用
-	Graph &operator<<(const pair<Line,ValueType> &edge);
+	Graph &operator<<(const pair<LineType, ValueType> &edge);
 
 	//在有向图中查找vs->ve的权值,const表示常量成员函数,标明此函数不会修改成员变量
-	ValueType operator()(int vs, int ve) const;
+	ValueType operator()(IndexType vs, IndexType ve) const;
 
-	//计算vs->ve的最短路径,详见此函数的实现部分
-	ValueType shortestPath(int vs, int ve, vector<int> &edges) const;
+	//计算vs->ve的最短路径,mask非空时不经过其中的结点和边,详见此函数的实现部分
+	ValueType shortestPath(IndexType vs, IndexType ve, vector<IndexType> &edges,
+		const ForbiddenMask<ValueType, IndexType> *mask = nullptr) const;
 
-	//计算vs->ve的结点数为m的最短路径,详见此函数的实现部分
+	//计算vs->ve的结点数为m的最短路径,mask非空时不经过其中的结点和边,详见此函数的实现部分
 	ValueType verticeConstrainedShortestPath(
-		int vs, int ve, int m, vector<int> &edges
+		IndexType vs, IndexType ve, int m, vector<IndexType> &edges,
+		const ForbiddenMask<ValueType, IndexType> *mask = nullptr
 	);
 
 	//去除所有边的权重
 	void removeWeights();
 
+	//批量插入,删除和修改边,详见此函数的实现部分
+	vector<EdgeChange<ValueType, IndexType>> update(const vector<pair<LineType, ValueType>> &batch);
+
+	template <typename, typename>
 	friend class GA;
+
+	template <typename, typename>
+	friend class KShortestPaths;
+
+	template <typename, typename>
+	friend class ForbiddenMask;
+
+	template <typename, typename>
+	friend class DynamicShortestPaths;
+
+	template <typename, typename>
+	friend class HopFront;
+
+	template <typename, typename>
+	friend class HopMatrix;
+};
+
+//静态常量成员的定义,以vector构造函数等按引用使用时需要
+template <typename ValueType, typename IndexType>
+constexpr ValueType Graph<ValueType, IndexType>::inf;
+
+template <typename ValueType, typename IndexType>
+constexpr IndexType Graph<ValueType, IndexType>::npos;
+
+
+/*
+ * 查询时屏蔽的结点和边(不经结点和不经线段)
+ * 基础路网不变而不经结点和线段随请求变化时,所有请求共用一个Graph,每个请求只需修改屏蔽集合,
+ * 不必删除边后重新构造Graph
+ * 结点按内部编号,边按在关联矩阵中的存储位置以位图存储,查询时在松弛循环中直接检查
+ * 构造时分配位图,之后forbidVertex,forbidEdge和clear的开销只与屏蔽的结点和边数有关
+ * 屏蔽集合只能用于构造时指定的graph,复制的Graph可用rebind转换
+ * graph插入新边或结点(改变存储位置)后,须调用refresh按已屏蔽的结点和边重建位图再用于查询,查询时以assert检查;
+ * forbidVertex,forbidEdge和clear会先自动refresh
+ * 应用举例：
+ * ForbiddenMask<double> mask(graph);
+ * mask.forbidVertex(5);
+ * mask.forbidEdge(2, 3);
+ * graph.shortestPath(0, 17, path, &mask);
+ * mask.clear();		//下一个请求
+ */
+template <typename ValueType, typename IndexType = int>
+class ForbiddenMask
+{
+private:
+	const Graph<ValueType, IndexType> *graph;
+	size_t layout;									//位图对应的graph->layoutVersion
+	vector<uint64_t> vertexBits, edgeBits;
+	vector<IndexType> vertices;						//已屏蔽的结点(内部编号)
+	vector<pair<IndexType, IndexType>> lines;		//已屏蔽的边(内部编号)
+
+	//超出位图范围的结点和边(如之后插入的)视为未屏蔽
+	static bool test(const vector<uint64_t> &bits, size_t i)
+	{
+		return (i >> 6) < bits.size() && ((bits[i >> 6] >> (i & 63)) & 1);
+	}
+
+	//按graph当前的结点数和边数分配全0的位图
+	void allocate()
+	{
+		layout = graph->layoutVersion;
+		vertexBits.assign((graph->graph.rows() + 63) / 64, 0);
+		edgeBits.assign((graph->graph.outerIndexPtr()[graph->graph.outerSize()] + 63) / 64, 0);
+	}
+
+	static void assign(vector<uint64_t> &bits, size_t i, bool value)
+	{
+		if (value)
+			bits[i >> 6] |= uint64_t(1) << (i & 63);
+		else
+			bits[i >> 6] &= ~(uint64_t(1) << (i & 63));
+	}
+
+public:
+	explicit ForbiddenMask(const Graph<ValueType, IndexType> &_graph)
+		: graph(&_graph)
+	{
+		allocate();
+	}
+
+	/*
+	 * @function name : refresh
+	 * @description : graph的存储位置改变后,按已屏蔽的结点和边重新建立位图
+	 *                结点的内部编号不变;已屏蔽的边若已被删除则不再屏蔽
+	 */
+	void refresh()
+	{
+		if (layout == graph->layoutVersion)
+			return;
+		allocate();
+		for (IndexType u : vertices)
+			assign(vertexBits, u, true);
+		size_t kept = 0;
+		for (auto &line : lines)
+		{
+			size_t e = graph->edgeIndex(line.first, line.second);
+			if (e == numeric_limits<size_t>::max())
+				continue;
+			assign(edgeBits, e, true);
+			lines[kept++] = line;
+		}
+		lines.resize(kept);
+	}
+
+	//位图是否与graph当前的存储位置一致,查询前检查
+	bool current(const Graph<ValueType, IndexType> &_graph) const
+	{
+		return graph == &_graph && layout == _graph.layoutVersion;
+	}
+
+	//屏蔽结点v(输入编号),v不存在时返回false
+	bool forbidVertex(IndexType v)
+	{
+		refresh();
+		if (!graph->contains(v))
+			return false;
+		IndexType u = graph->inner(v);
+		if (!test(vertexBits, u))
+		{
+			assign(vertexBits, u, true);
+			vertices.push_back(u);
+		}
+		return true;
+	}
+
+	//屏蔽边vs->ve(输入编号),边不存在时返回false
+	bool forbidEdge(IndexType vs, IndexType ve)
+	{
+		refresh();
+		if (!graph->contains(vs) || !graph->contains(ve))
+			return false;
+		IndexType u = graph->inner(vs), v = graph->inner(ve);
+		size_t e = graph->edgeIndex(u, v);
+		if (e == numeric_limits<size_t>::max())
+			return false;
+		if (!test(edgeBits, e))
+		{
+			assign(edgeBits, e, true);
+			lines.push_back({ u, v });
+		}
+		return true;
+	}
+
+	//清除所有屏蔽
+	void clear()
+	{
+		//存储位置已改变时直接重新分配,不能再按边的位置逐个复位
+		if (layout != graph->layoutVersion)
+			allocate();
+		else
+		{
+			for (IndexType u : vertices)
+				assign(vertexBits, u, false);
+			for (auto &line : lines)
+				assign(edgeBits, graph->edgeIndex(line.first, line.second), false);
+		}
+		vertices.clear();
+		lines.clear();
+	}
+
+	//将屏蔽集合转换到另一个顶点编号相同的Graph(如graph的副本)
+	ForbiddenMask rebind(const Graph<ValueType, IndexType> &other) const
+	{
+		ForbiddenMask mask(other);
+		for (IndexType u : vertices)
+			mask.forbidVertex(graph->outer(u));
+		for (auto &line : lines)
+			mask.forbidEdge(graph->outer(line.first), graph->outer(line.second));
+		return mask;
+	}
+
+	bool empty() const
+	{
+		return vertices.empty() && lines.empty();
+	}
+
+	//内部编号为u的结点是否被屏蔽
+	bool vertex(IndexType u) const
+	{
+		return test(vertexBits, static_cast<size_t>(u));
+	}
+
+	//存储位置为e的边是否被屏蔽
+	bool edge(size_t e) const
+	{
+		return test(edgeBits, e);
+	}
+
+	//已屏蔽的结点和边(内部编号)
+	const vector<IndexType> &forbiddenVertices() const
+	{
+		return vertices;
+	}
+
+	const vector<pair<IndexType, IndexType>> &forbiddenLines() const
+	{
+		return lines;
+	}
 };
 
 
@@ -80,28 +391,15 @@ public:
 *     { {2,3}, 4.2 }
 * };
 * Graph<double> graph(collection);
+* Graph<double> graph(collection, VertexOrder::RCM);	//按RCM顺序重新编号
+* Graph<float, uint16_t> graph(collection);			//使用较小的权值和编号类型
 */
-template<typename ValueType>
+template<typename ValueType, typename IndexType>
 template<typename Container>
-inline Graph<ValueType>::Graph(const Container &collection)
+inline Graph<ValueType, IndexType>::Graph(const Container &collection,
+	VertexOrder order, const vector<Point> *coords)
 {
-	//确定关联矩阵的大小(图中顶点的个数)
-	size_t size = 0;
-	for (auto &item : collection)
-	{
-		const Line &edge = item.first;
-		if (edge.first >= size)
-			size = edge.first + 1;
-		if (edge.second >= size)
-			size = edge.second + 1;
-	}
-	graph.resize(size, size);
-	//在关联矩阵中插入边
-	for (auto &item : collection)
-	{
-		const Line &edge = item.first;
-		graph.insert(edge.first, edge.second) = item.second;
-	}
+	build(collection, order, coords);
 }
 
 /*
@@ -114,26 +412,55 @@ inline Graph<ValueType>::Graph(const Container &collection)
 *     { {2,3}, 4.2}
 * };
 */
-template <typename ValueType>
-Graph<ValueType>::Graph(const initializer_list < pair<Line, ValueType> > &initializer)
+template <typename ValueType, typename IndexType>
+Graph<ValueType, IndexType>::Graph(const initializer_list < pair<LineType, ValueType> > &initializer,
+	VertexOrder order, const vector<Point> *coords)
+{
+	build(initializer, order, coords);
+}
+
+template<typename ValueType, typename IndexType>
+template<typename Container>
+inline void Graph<ValueType, IndexType>::build(const Container &collection,
+	VertexOrder order, const vector<Point> *coords)
 {
+	PROFILE_SCOPE("Graph::build");
 	//确定关联矩阵的大小(图中顶点的个数)
 	size_t size = 0;
-	for (auto &item : initializer)
+	vector<Line> lines;
+	for (auto &item : collection)
 	{
-		const Line &edge = item.first;
-		if (edge.first >= size)
-			size = edge.first + 1;
-		if (edge.second >= size)
-			size = edge.second + 1;
+		size_t vs = static_cast<size_t>(item.first.first);
+		size_t ve = static_cast<size_t>(item.first.second);
+		if (vs >= size)
+			size = vs + 1;
+		if (ve >= size)
+			size = ve + 1;
+		lines.push_back(Line(static_cast<int>(vs), static_cast<int>(ve)));
 	}
+	//顶点数必须能用IndexType表示(最大值保留为npos),且不超过关联矩阵下标的范围
+	if (size >= static_cast<size_t>(npos) || size > static_cast<size_t>(numeric_limits<int>::max()))
+		throw length_error("顶点数超出了顶点编号类型的表示范围");
+	//计算顶点重排序
+	vector<int> vertexOrder = computeVertexOrder(size, lines, order, coords);
+	toOuter.assign(vertexOrder.begin(), vertexOrder.end());
+	toInner.assign(toOuter.size(), 0);
+	for (size_t v = 0; v < toOuter.size(); v++)
+		toInner[toOuter[v]] = static_cast<IndexType>(v);
+	//按内部编号预留每行的空间,避免逐条插入时反复移动数据
 	graph.resize(size, size);
+	VectorXi rowSize = VectorXi::Zero(size);
+	for (auto &edge : lines)
+		rowSize[inner(edge.first)]++;
+	graph.reserve(rowSize);
 	//在关联矩阵中插入边
-	for (auto &item : initializer)
+	size_t e = 0;
+	for (auto &item : collection)
 	{
-		const Line &edge = item.first;
-		graph.insert(edge.first, edge.second) = item.second;
+		const Line &edge = lines[e++];
+		graph.insert(inner(edge.first), inner(edge.second)) = item.second;
 	}
+	graph.makeCompressed();
 }
 
 
@@ -144,28 +471,29 @@ Graph<ValueType>::Graph(const initializer_list < pair<Line, ValueType> > &initia
  * Graph<double> graph;
  * graph << pair<Line,double>({1,2},3.5) << pair<Line,double>({2,3},4.2);
  */
-template <typename ValueType>
-inline Graph<ValueType> &Graph<ValueType>::operator<<(const pair<Line, ValueType> &item)
+template <typename ValueType, typename IndexType>
+inline Graph<ValueType, IndexType> &Graph<ValueType, IndexType>::operator<<(const pair<LineType, ValueType> &item)
 {
-	const Line &edge = item.first;
-	assert(edge.first < graph.rows() && edge.second < graph.cols());
-	graph.insert(edge.first, edge.second) = item.second;
+	const LineType &edge = item.first;
+	assert(contains(edge.first) && contains(edge.second));
+	graph.insert(inner(edge.first), inner(edge.second)) = item.second;
+	layoutVersion++;
 	return *this;
 }
 
 
 //在有向图中查找vs->ve的权值
-template <typename ValueType>
-inline ValueType Graph<ValueType>::operator()(int vs, int ve) const
+template <typename ValueType, typename IndexType>
+inline ValueType Graph<ValueType, IndexType>::operator()(IndexType vs, IndexType ve) const
 {
 	//首尾结点相同,直接返回0
 	if (vs == ve)
 		return 0;
 	//vs或ve不存在,直接返回∞
-	if (vs >= graph.rows() || ve >= graph.cols())
+	if (!contains(vs) || !contains(ve))
 		return inf;
 	//在稀疏矩阵graph中查找vs->ve的权值
-	ValueType value = graph.coeff(vs, ve);
+	ValueType value = graph.coeff(inner(vs), inner(ve));
 	return value ? value : inf;
 }
 
@@ -176,84 +504,77 @@ inline ValueType Graph<ValueType>::operator()(int vs, int ve) const
  * @inparam : vs 起始结点
  * @inparam : ve 终止结点
  * @outparam : edges 最短路径
+ * @inparam : mask 不能经过的结点和边,为空表示不屏蔽
  * @return : 最短路径的长度
  */
-template <typename ValueType>
-inline ValueType Graph<ValueType>::shortestPath(int vs, int ve, vector<int> &edges) const
+template <typename ValueType, typename IndexType>
+inline ValueType Graph<ValueType, IndexType>::shortestPath(IndexType vs, IndexType ve, vector<IndexType> &edges,
+	const ForbiddenMask<ValueType, IndexType> *mask) const
 {
+	assert(!mask || mask->current(*this));
 	//起始结点或终止结点不存在,则路径长度为∞
-	if (vs >= graph.rows() || ve >= graph.cols())
+	if (!contains(vs) || !contains(ve))
+		return inf;
+	//转换为内部编号
+	IndexType s = inner(vs), t = inner(ve);
+	//起始结点或终止结点被屏蔽
+	if (mask && (mask->vertex(s) || mask->vertex(t)))
 		return inf;
 	//定义本算法用到的数据结构
-	size_t n = graph.size();
-	bool *S = new bool[n];
-	auto *dist = new ValueType[n];
-	auto *path = new int[n];
-	//初始化
-	for (int v = 0; v < n; v++)
+	size_t n = graph.rows();
+	vector<bool> S(n, false);		//已确定最短路径的结点
+	vector<ValueType> dist(n, inf);
+	vector<IndexType> path(n, npos);
+	//小根堆,存储(距离,结点),结点被更新时重复入堆,出堆时跳过已确定的结点
+	typedef pair<ValueType, IndexType> HeapItem;
+	priority_queue<HeapItem, vector<HeapItem>, greater<HeapItem>> heap;
+	size_t settled = 0, relaxed = 0, pushes = 1, pops = 0;		//性能计数
+	dist[s] = 0;
+	heap.push(HeapItem(0, s));
+	//计算最短路径,只遍历关联矩阵中当前结点所在行的非零元素
+	while (!heap.empty())
 	{
-		S[v] = false;
-		dist[v] = getEdgeValue(vs, v);
-		if (dist[v] < inf)
-			path[v] = vs;
-		else
-			path[v] = -1;
-	}
-	dist[vs] = 0;
-	S[vs] = true;
-	//计算最短路径
-	for (int i = 1; i < n; i++)
-	{
-		ValueType min = inf;
-		int k = -1;
-		for (int j = 0; j < n; j++)
-		{
-			if (!S[j] && dist[j] < min)
-			{
-				k = j;
-				min = dist[j];
-			}
-		}
-		if (k == -1)
-			break;
+		IndexType k = heap.top().second;
+		heap.pop();
+		pops++;
+		if (S[k])
+			continue;
 		S[k] = true;
-		for (int w = 0; w < n; w++)
+		settled++;
+		if (k == t)
+			break;
+		for (EdgeIterator it(graph, k); it; ++it)
 		{
-			ValueType distKW = getEdgeValue(k, w);
-			if (dist[k] < inf &&
-				distKW < inf
-				&& !S[w]
-				&& dist[k] + distKW < dist[w])
+			IndexType w = static_cast<IndexType>(it.index());
+			if (it.value() == 0 || (mask && (mask->vertex(w) || mask->edge(edgeIndex(it)))))
+				continue;
+			if (!S[w] && dist[k] + it.value() < dist[w])
 			{
-				dist[w] = dist[k] + distKW;
+				dist[w] = dist[k] + it.value();
 				path[w] = k;
+				heap.push(HeapItem(dist[w], w));
+				pushes++;
 			}
+			relaxed++;
 		}
 	}
+	PROFILE_COUNT("shortestPath.calls", 1);
+	PROFILE_COUNT("shortestPath.settled", settled);
+	PROFILE_COUNT("shortestPath.relaxations", relaxed);
+	PROFILE_COUNT("shortestPath.heapPushes", pushes);
+	PROFILE_COUNT("shortestPath.heapPops", pops);
 	//转换为路径
-	vector<int> rPath;	//反向路径
-	for (int idx = ve; idx != vs; idx = path[idx])
+	vector<IndexType> rPath;	//反向路径
+	for (IndexType idx = t; idx != s; idx = path[idx])
 	{
-		if (idx == -1)	//路径上某结点的前驱结点是-1,无法达到vs,标明vs->ve不连通
-		{
-			delete[]path;
-			delete[]S;
-			delete[]dist;
+		if (idx == npos)	//路径上某结点的前驱结点是npos,无法达到vs,标明vs->ve不连通
 			return inf;
-		}
-		rPath.push_back(idx);
+		rPath.push_back(outer(idx));
 	}
 	rPath.push_back(vs);
 	//反向路径->正向路径
-	edges.resize(rPath.size());
-	for (size_t i = 0; i < edges.size(); i++)
-		edges[i] = rPath[edges.size() - i - 1];
-	//释放内存
-	ValueType minDist = dist[ve];
-	delete[]path;
-	delete[]S;
-	delete[]dist;
-	return minDist;
+	edges.assign(rPath.rbegin(), rPath.rend());
+	return dist[t];
 }
 
 
@@ -265,77 +586,194 @@ inline ValueType Graph<ValueType>::shortestPath(int vs, int ve, vector<int> &edg
  * @inparam : ve 终止结点
  * @inparam : k 经过的结点数(包括起点和终点)
  * @outparam : edges 最短路径
+ * @inparam : mask 不能经过的结点和边,为空表示不屏蔽
  * @return : 最短路径的长度
  */
-template <typename ValueType>
-inline ValueType Graph<ValueType>::verticeConstrainedShortestPath(
-	int vs, int ve, int k, vector<int> &edges
+template <typename ValueType, typename IndexType>
+inline ValueType Graph<ValueType, IndexType>::verticeConstrainedShortestPath(
+	IndexType vs, IndexType ve, int k, vector<IndexType> &edges,
+	const ForbiddenMask<ValueType, IndexType> *mask
 )
 {
+	assert(!mask || mask->current(*this));
 	//最少包含起始和终点，k至少>=2
 	if (k < 2)
 		return inf;
+	//起始结点或终止结点不存在,则路径长度为∞
+	if (!contains(vs) || !contains(ve))
+		return inf;
+	//转换为内部编号
+	IndexType s = inner(vs), t = inner(ve);
+	//起始结点或终止结点被屏蔽
+	if (mask && (mask->vertex(s) || mask->vertex(t)))
+		return inf;
 	//定义本算法用到的数据结构
 	size_t n = graph.rows();				//有向图的结点数
-	ValueType *dist = new ValueType[n];		//vs->其他顶点的最短路径
-	ValueType *pdist = new ValueType[n];	//上一轮循环的dist
-	int **path = new int*[k - 1];			//存储每一轮循环的前驱结点
-	for (size_t i = 0; i < k - 1; i++)
-		path[i] = new int[n];
+	vector<ValueType> dist(n, inf);			//vs->其他顶点的最短路径
+	vector<ValueType> pdist;				//上一轮循环的dist
+	vector<bool> improved(n);				//本轮循环中dist被更新的结点
+	vector<IndexType> path((k - 1) * n, s);	//存储每一轮循环的前驱结点,第m轮为path[m*n] ~ path[m*n+n-1]
 	//初始化
-	for (int i = 0; i < n; i++)
-	{
-		dist[i] = getEdgeValue(vs, i);
-		path[0][i] = vs;
-		pdist[i] = dist[i];
-	}
+	dist[s] = 0;
+	for (EdgeIterator it(graph, s); it; ++it)
+		if (it.index() != static_cast<Index>(s) && it.value() != 0 &&
+			!(mask && (mask->vertex(static_cast<IndexType>(it.index())) || mask->edge(edgeIndex(it)))))
+			dist[it.index()] = it.value();
+	pdist = dist;
 	//计算受结点数限制的最短路径
+	//每一轮沿上一轮可达结点的出边松弛,只遍历关联矩阵的非零元素
+	PROFILE_SCOPE("verticeConstrainedShortestPath");
+	size_t relaxed = 0;
 	for (int m = 1; m < k - 1; m++)
 	{
-		for (int j = 0; j < n; j++)
+		IndexType *pathM = &path[m * n];
+		const IndexType *pathPrev = &path[(m - 1) * n];
+		fill(improved.begin(), improved.end(), false);
+		for (size_t i = 0; i < n; i++)
 		{
-			for (int i = 0; i < n; i++)
+			if (pdist[i] == inf)
+				continue;
+			for (EdgeIterator it(graph, i); it; ++it)
 			{
-				ValueType cost = getEdgeValue(i, j);
-				if (pdist[i] < inf && cost < inf && dist[j] > pdist[i] + cost)
+				size_t j = static_cast<size_t>(it.index());
+				relaxed++;
+				if (it.value() == 0 || (mask && (mask->vertex(static_cast<IndexType>(j)) || mask->edge(edgeIndex(it)))))
+					continue;
+				if (j != i && dist[j] > pdist[i] + it.value())
 				{
-					dist[j] = pdist[i] + cost;
-					path[m][j] = i;
+					dist[j] = pdist[i] + it.value();
+					pathM[j] = static_cast<IndexType>(i);
+					improved[j] = true;
 				}
 			}
-			if (dist[j] == pdist[j])
-				path[m][j] = path[m - 1][j];
 		}
-		for (int u = 0; u < n; u++)
-			pdist[u] = dist[u];
+		for (size_t j = 0; j < n; j++)
+			if (!improved[j])
+				pathM[j] = pathPrev[j];
+		pdist = dist;
 	}
+	PROFILE_COUNT("verticeConstrainedShortestPath.relaxations", relaxed);
 	//输出路径
 	edges.resize(k);
-	int j = ve;
+	IndexType j = t;
 	for (int m = k - 2; m >= 0; m--)
 	{
-		edges[m] = path[m][j];
-		j = path[m][j];
+		j = path[m * n + j];
+		edges[m] = outer(j);
 	}
 	edges[k - 1] = ve;
-	ValueType minDist = dist[ve];
-	//释放内存
-	delete[]dist;
-	delete[]pdist;
-	for (size_t i = 0; i < k - 1; i++)
-		delete[]path[i];
-	delete[]path;
-	return minDist;
+	return dist[t];
 }
 
 //去除所有边的权重,使之变成无权图
-template<typename ValueType>
-inline void Graph<ValueType>::removeWeights()
+template<typename ValueType, typename IndexType>
+inline void Graph<ValueType, IndexType>::removeWeights()
+{
+	for (int i = 0; i < graph.outerSize(); i++)
+		for (EdgeIterator it(graph, i); it; ++it)
+			if (it.value() != 0)
+				it.valueRef() = 1;
+}
+
+/*
+ * @function name : update
+ * @description : 批量插入,删除和修改边,不重新构造有向图
+ *                已有存储位置的边(包括此前删除的边)在原位修改,删除的边保留存储位置,权值置为0
+ *                只有插入新边时才将新边与原有的边逐行合并一次,同时去除已删除的边,开销为O(E+b·log b)
+ *                插入新边会改变边的存储位置,此前构造的ForbiddenMask需要调用refresh
+ * @inparam : batch 边及其新权值(输入编号),权值为0表示删除;同一条边出现多次时以最后一次为准
+ *                  权值为负时抛出invalid_argument,结点编号(包括负数)超出IndexType的表示范围时抛出length_error
+ *                  两种情况都在修改之前检查,抛出异常时有向图不做任何修改
+ *                  新边的端点可以是新结点,新结点的内部编号与输入编号相同
+ * @return : 实际发生的修改(输入编号),每条边最多一项
+ */
+template <typename ValueType, typename IndexType>
+vector<EdgeChange<ValueType, IndexType>> Graph<ValueType, IndexType>::update(
+	const vector<pair<LineType, ValueType>> &batch)
 {
-	for (int i = 0; i < graph.rows(); i++)
-		for (int j = 0; j < graph.cols(); j++)
-			if (graph.coeff(i, j) != 0)
-				graph.coeffRef(i, j) = 1;
+	PROFILE_SCOPE("Graph::update");
+	size_t n = graph.rows(), size = n;
+	//先检查整个批次,保证抛出异常时有向图未被修改;负的结点编号转换为size_t后超出范围
+	for (auto &item : batch)
+	{
+		if (!(item.second >= 0))
+			throw invalid_argument("边的权值不能为负");
+		size_t v = max(static_cast<size_t>(item.first.first), static_cast<size_t>(item.first.second));
+		if (v >= static_cast<size_t>(npos) - 1 || v >= static_cast<size_t>(numeric_limits<int>::max()))
+			throw length_error("顶点数超出了顶点编号类型的表示范围");
+		size = max(size, v + 1);
+	}
+	//按边(内部编号)合并同一批次中的多次修改
+	map<LineType, EdgeChange<ValueType, IndexType>> changes;
+	map<LineType, ValueType> inserts;		//需要新存储位置的边
+	for (auto &item : batch)
+	{
+		//新结点的内部编号与输入编号相同,inner和outer对超出范围的编号原样返回
+		LineType edge(inner(item.first.first), inner(item.first.second));
+		size_t e = static_cast<size_t>(edge.first) < n ? edgeIndex(edge.first, edge.second) : numeric_limits<size_t>::max();
+		ValueType old;
+		if (e != numeric_limits<size_t>::max())
+		{
+			old = graph.valuePtr()[e];
+			graph.valuePtr()[e] = item.second;
+		}
+		else
+		{
+			auto found = inserts.find(edge);
+			old = found == inserts.end() ? 0 : found->second;
+			if (item.second != 0)
+				inserts[edge] = item.second;
+			else if (found != inserts.end())
+				inserts.erase(found);
+		}
+		auto found = changes.find(edge);
+		if (found == changes.end())
+			changes[edge] = EdgeChange<ValueType, IndexType>{ item.first.first, item.first.second, old, item.second };
+		else
+			found->second.newWeight = item.second;
+	}
+	//合并新边,每行的边按终点编号有序
+	if (!inserts.empty())
+	{
+		graph.makeCompressed();
+		SparseMatrix<ValueType, RowMajor> merged(size, size);
+		merged.resizeNonZeros(graph.nonZeros() + inserts.size());
+		auto next = inserts.begin();
+		Index pos = 0;
+		auto write = [&](Index v, ValueType w)
+		{
+			if (w == 0)
+				return;
+			merged.innerIndexPtr()[pos] = static_cast<int>(v);
+			merged.valuePtr()[pos] = w;
+			pos++;
+		};
+		for (Index u = 0; u < static_cast<Index>(size); u++)
+		{
+			merged.outerIndexPtr()[u] = static_cast<int>(pos);
+			if (u < static_cast<Index>(n))
+				for (EdgeIterator it(graph, u); it; ++it)
+				{
+					for (; next != inserts.end() && static_cast<Index>(next->first.first) == u &&
+						static_cast<Index>(next->first.second) < it.index(); ++next)
+						write(next->first.second, next->second);
+					write(it.index(), it.value());
+				}
+			for (; next != inserts.end() && static_cast<Index>(next->first.first) == u; ++next)
+				write(next->first.second, next->second);
+		}
+		merged.outerIndexPtr()[size] = static_cast<int>(pos);
+		merged.resizeNonZeros(pos);
+		graph.swap(merged);
+		layoutVersion++;
+	}
+	vector<EdgeChange<ValueType, IndexType>> result;
+	for (auto &item : changes)
+		if (item.second.oldWeight != item.second.newWeight)
+			result.push_back(item.second);
+	PROFILE_COUNT("Graph::update.changes", result.size());
+	PROFILE_COUNT("Graph::update.inserts", inserts.size());
+	return result;
 }
 
 #endif // _GRAPH_H_
\ No newline at end of file
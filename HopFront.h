@@ -0,0 +1,166 @@
+﻿#ifndef _HOP_FRONT_H_		//防止头文件被重复包含
+#define _HOP_FRONT_H_
+
+#include "stdafx.h"
+#include "Graph.h"
+
+/*
+ * 代价-边数Pareto前沿
+ * 从vs出发按边数分层松弛一次(与verticeConstrainedShortestPath相同),得到vs到所有结点
+ * 在边数不超过1,2,...,maxHops时的最短距离,可按需取出任一边数限制下的路径
+ * 每个结点只在距离变小的层记录一个标号(距离,前驱标号),同一结点的标号按层数链接：
+ *   1. 标号的层数即为达到该距离所需的最少边数,结点的所有标号构成它的Pareto前沿
+ *   2. 每层只从上一层距离变小的结点出发松弛,其他结点的出边在之前的层已松弛过
+ * 内存与距离变小的次数成正比,而不是maxHops×结点数
+ * 应用举例：
+ * HopFront<double> front(graph, 0, 20);
+ * front.cost(17, 11);						//0->17在11条边以内的最短距离
+ * front.path(17, 11, path);				//对应的路径
+ * for (auto &point : front.front(17))		//(边数, 代价),边数递增,代价递减
+ *     ...
+ */
+template <typename ValueType, typename IndexType = int>
+class HopFront
+{
+private:
+	typedef typename Graph<ValueType, IndexType>::EdgeIterator EdgeIterator;
+
+	const ValueType unreached = numeric_limits<ValueType>::max();
+	const size_t none = numeric_limits<size_t>::max();
+
+	//结点在某一层的标号
+	struct Label
+	{
+		IndexType vertex;
+		size_t hops;		//达到dist所需的最少边数
+		ValueType dist;
+		size_t pred;		//前驱结点的标号
+		size_t prev;		//同一结点上一个(边数更少,距离更大)的标号
+	};
+
+	const Graph<ValueType, IndexType> &graph;
+	IndexType source;		//内部编号
+	size_t layers;			//实际计算的层数,之后各层的距离不再变化
+	vector<Label> labels;
+	vector<size_t> last;	//各结点最新的标号
+
+	//结点v(内部编号)在边数不超过hops时的标号,不可达时返回none
+	size_t labelAt(IndexType v, size_t hops) const
+	{
+		size_t l = last[v];
+		while (l != none && labels[l].hops > hops)
+			l = labels[l].prev;
+		return l;
+	}
+
+public:
+	/*
+	 * 构造函数,计算Pareto前沿
+	 * vs为起始结点,maxHops为最大边数,mask为不能经过的结点和边
+	 * vs不存在或被屏蔽时所有结点均不可达
+	 */
+	HopFront(const Graph<ValueType, IndexType> &_graph, IndexType vs, size_t maxHops,
+		const ForbiddenMask<ValueType, IndexType> *mask = nullptr)
+		: graph(_graph), source(_graph.inner(vs)), layers(0),
+		last(_graph.graph.rows(), numeric_limits<size_t>::max())
+	{
+		PROFILE_SCOPE("HopFront");
+		assert(!mask || mask->current(graph));
+		if (!graph.contains(vs) || (mask && mask->vertex(source)))
+			return;
+		size_t n = graph.graph.rows();
+		vector<ValueType> best(n, unreached);		//各结点目前的最短距离
+		vector<size_t> current(n, none);			//各结点在当前层的标号
+		vector<size_t> frontier, next;				//上一层和当前层距离变小的结点的标号
+		labels.push_back(Label{ source, 0, 0, none, none });
+		last[source] = 0;
+		best[source] = 0;
+		frontier.push_back(0);
+		size_t relaxed = 0;
+		for (size_t m = 1; m <= maxHops && !frontier.empty(); m++)
+		{
+			next.clear();
+			for (size_t f : frontier)
+			{
+				//labels在循环中会增长,先复制
+				IndexType i = labels[f].vertex;
+				ValueType d = labels[f].dist;
+				for (EdgeIterator it(graph.graph, i); it; ++it)
+				{
+					IndexType j = static_cast<IndexType>(it.index());
+					relaxed++;
+					if (it.value() == 0 || j == i || d + it.value() >= best[j] ||
+						(mask && (mask->vertex(j) || mask->edge(graph.edgeIndex(it)))))
+						continue;
+					best[j] = d + it.value();
+					if (current[j] != none && labels[current[j]].hops == m)
+					{
+						labels[current[j]].dist = best[j];
+						labels[current[j]].pred = f;
+					}
+					else
+					{
+						current[j] = labels.size();
+						labels.push_back(Label{ j, m, best[j], f, last[j] });
+						last[j] = current[j];
+						next.push_back(current[j]);
+					}
+				}
+			}
+			frontier.swap(next);
+			layers = m;
+		}
+		PROFILE_COUNT("HopFront.relaxations", relaxed);
+		PROFILE_COUNT("HopFront.labels", labels.size());
+	}
+
+	//实际计算的层数,边数限制超过此值时结果不再变化
+	size_t computedHops() const
+	{
+		return layers;
+	}
+
+	//边数不超过hops时vs->ve的最短距离,不可达时为ValueType的最大值
+	ValueType cost(IndexType ve, size_t hops) const
+	{
+		if (!graph.contains(ve))
+			return unreached;
+		size_t l = labelAt(graph.inner(ve), hops);
+		return l == none ? unreached : labels[l].dist;
+	}
+
+	//vs->ve的Pareto前沿(边数, 代价),边数递增,代价严格递减
+	vector<pair<size_t, ValueType>> front(IndexType ve) const
+	{
+		vector<pair<size_t, ValueType>> points;
+		if (!graph.contains(ve))
+			return points;
+		for (size_t l = last[graph.inner(ve)]; l != none; l = labels[l].prev)
+			points.push_back({ labels[l].hops, labels[l].dist });
+		reverse(points.begin(), points.end());
+		return points;
+	}
+
+	/*
+	 * @function name : path
+	 * @description : 取出边数不超过hops时vs->ve的最短路径
+	 * @outparam : edges 路径(输入编号),边数为达到该距离所需的最少边数
+	 * @return : 路径的长度,不可达时为ValueType的最大值且edges为空
+	 */
+	ValueType path(IndexType ve, size_t hops, vector<IndexType> &edges) const
+	{
+		edges.clear();
+		if (!graph.contains(ve))
+			return unreached;
+		size_t l = labelAt(graph.inner(ve), hops);
+		if (l == none)
+			return unreached;
+		ValueType dist = labels[l].dist;
+		for (; l != none; l = labels[l].pred)
+			edges.push_back(graph.outer(labels[l].vertex));
+		reverse(edges.begin(), edges.end());
+		return dist;
+	}
+};
+
+#endif // _HOP_FRONT_H_
@@ -0,0 +1,281 @@
+﻿#ifndef _HOP_MATRIX_H_		//防止头文件被重复包含
+#define _HOP_MATRIX_H_
+
+#include "stdafx.h"
+#include "Graph.h"
+
+//x中最低的非零位的位置,x不能为0
+inline size_t lowestBit(uint64_t x)
+{
+#ifdef _MSC_VER
+	unsigned long b;
+	_BitScanForward64(&b, x);
+	return b;
+#else
+	return __builtin_ctzll(x);
+#endif
+}
+
+//64个源结点的位集合,第b位表示第b个源结点
+struct HopBits64
+{
+	static const size_t width = 64;
+	uint64_t w;
+
+	static HopBits64 zero()
+	{
+		return HopBits64{ 0 };
+	}
+	void set(size_t b)
+	{
+		w |= uint64_t(1) << b;
+	}
+	void operator|=(const HopBits64 &other)
+	{
+		w |= other.w;
+	}
+	//返回*this & ~other
+	HopBits64 andNot(const HopBits64 &other) const
+	{
+		return HopBits64{ w & ~other.w };
+	}
+	bool any() const
+	{
+		return w != 0;
+	}
+	const uint64_t *words() const
+	{
+		return &w;
+	}
+};
+
+//256个源结点的位集合,编译时启用AVX指令集则使用256位向量指令,否则逐个64位字运算
+struct alignas(32) HopBits256
+{
+	static const size_t width = 256;
+	uint64_t w[4];
+
+	static HopBits256 zero()
+	{
+		return HopBits256{ { 0, 0, 0, 0 } };
+	}
+	void set(size_t b)
+	{
+		w[b / 64] |= uint64_t(1) << (b % 64);
+	}
+#ifdef __AVX__
+	//AVX只有浮点数的256位位运算(AVX2才有整数的),按位运算与数据类型无关
+	static __m256d load(const uint64_t *p)
+	{
+		return _mm256_castsi256_pd(_mm256_load_si256(reinterpret_cast<const __m256i *>(p)));
+	}
+	static void store(uint64_t *p, __m256d x)
+	{
+		_mm256_store_si256(reinterpret_cast<__m256i *>(p), _mm256_castpd_si256(x));
+	}
+	void operator|=(const HopBits256 &other)
+	{
+		store(w, _mm256_or_pd(load(w), load(other.w)));
+	}
+	HopBits256 andNot(const HopBits256 &other) const
+	{
+		HopBits256 r;
+		store(r.w, _mm256_andnot_pd(load(other.w), load(w)));
+		return r;
+	}
+	bool any() const
+	{
+		__m256i x = _mm256_load_si256(reinterpret_cast<const __m256i *>(w));
+		return !_mm256_testz_si256(x, x);
+	}
+#else
+	void operator|=(const HopBits256 &other)
+	{
+		for (int i = 0; i < 4; i++)
+			w[i] |= other.w[i];
+	}
+	HopBits256 andNot(const HopBits256 &other) const
+	{
+		HopBits256 r;
+		for (int i = 0; i < 4; i++)
+			r.w[i] = w[i] & ~other.w[i];
+		return r;
+	}
+	bool any() const
+	{
+		return (w[0] | w[1] | w[2] | w[3]) != 0;
+	}
+#endif
+	const uint64_t *words() const
+	{
+		return w;
+	}
+};
+
+/*
+ * 终点间的边数矩阵(位并行多源BFS)
+ * 计算一组终点(起点,终点,必经结点等)两两之间的最少边数,不考虑权值
+ * 每个结点为每批源结点保存一个位集合,每个源结点一位,一次遍历所有边即可使这一批源结点同时前进一层：
+ *   next[v] = (所有入边起点u的frontier[u]按位或) & ~visited[v]
+ * 源结点不超过64个时使用uint64_t,超过时每批256个(AVX),遍历次数为各批源结点到各终点的最大边数
+ * 每层按结点拉取入边上的位集合,各结点只写自己的位集合,使用OpenMP并行
+ * 应用举例：
+ * HopMatrix<double> hops(graph, { 0, 17, 7, 12 }, &mask);
+ * unsigned h = hops(0, 1);		//0->17的最少边数,不可达时为HopMatrix<double>::unreached
+ */
+template <typename ValueType, typename IndexType = int>
+class HopMatrix
+{
+private:
+	typedef typename Graph<ValueType, IndexType>::EdgeIterator EdgeIterator;
+
+	const IndexType npos = Graph<ValueType, IndexType>::npos;
+
+	size_t k;							//终点数
+	vector<IndexType> terminals;		//内部编号,不存在或被屏蔽的终点为npos
+	vector<unsigned> hops;				//k×k,hops[i*k+j]为第i个终点到第j个终点的最少边数
+
+	//可以经过的边的入边索引(CSR格式),结点v的入边起点为inFrom[inOffset[v]] ~ inFrom[inOffset[v+1]-1]
+	vector<size_t> inOffset;
+	vector<IndexType> inFrom;
+
+	//建立入边索引,跳过已删除的边,被屏蔽的边以及与被屏蔽结点相连的边
+	void buildInEdges(const Graph<ValueType, IndexType> &graph, const ForbiddenMask<ValueType, IndexType> *mask)
+	{
+		size_t n = graph.graph.rows();
+		auto usable = [&](Index u, const EdgeIterator &it)
+		{
+			return it.value() != 0 && (!mask || (!mask->vertex(static_cast<IndexType>(u)) &&
+				!mask->vertex(static_cast<IndexType>(it.index())) && !mask->edge(graph.edgeIndex(it))));
+		};
+		inOffset.assign(n + 1, 0);
+		for (Index u = 0; u < static_cast<Index>(n); u++)
+			for (EdgeIterator it(graph.graph, u); it; ++it)
+				if (usable(u, it))
+					inOffset[it.index() + 1]++;
+		for (size_t v = 0; v < n; v++)
+			inOffset[v + 1] += inOffset[v];
+		inFrom.resize(inOffset[n]);
+		vector<size_t> pos(inOffset.begin(), inOffset.end() - 1);
+		for (Index u = 0; u < static_cast<Index>(n); u++)
+			for (EdgeIterator it(graph.graph, u); it; ++it)
+				if (usable(u, it))
+					inFrom[pos[it.index()]++] = static_cast<IndexType>(u);
+	}
+
+	/*
+	 * @function name : sweep
+	 * @description : 以第first ~ first+count-1个终点为源结点进行一批BFS,填写hops中对应的行
+	 * @inparam : Block 位集合类型,count不超过Block::width
+	 */
+	template <typename Block>
+	void sweep(size_t first, size_t count)
+	{
+		size_t n = inOffset.size() - 1;
+		vector<Block, aligned_allocator<Block>> visited(n, Block::zero());
+		vector<Block, aligned_allocator<Block>> frontier(n, Block::zero()), next(n, Block::zero());
+		size_t remaining = 0;		//尚未到达的(源结点,终点)对
+		for (size_t b = 0; b < count; b++)
+		{
+			IndexType s = terminals[first + b];
+			if (s == npos)
+				continue;
+			visited[s].set(b);
+			frontier[s].set(b);
+			for (size_t j = 0; j < k; j++)
+				if (terminals[j] == s)
+					hops[(first + b) * k + j] = 0;
+				else if (terminals[j] != npos)
+					remaining++;
+		}
+		size_t levels = 0;
+		for (unsigned level = 1; remaining > 0; level++)
+		{
+			int changed = 0;
+#pragma omp parallel for reduction(|:changed)
+			for (int v = 0; v < static_cast<int>(n); v++)
+			{
+				Block reached = Block::zero();
+				for (size_t i = inOffset[v]; i < inOffset[v + 1]; i++)
+					reached |= frontier[inFrom[i]];
+				next[v] = reached.andNot(visited[v]);
+				if (next[v].any())
+				{
+					visited[v] |= next[v];
+					changed = 1;
+				}
+			}
+			if (!changed)
+				break;
+			frontier.swap(next);
+			levels++;
+			//记录本层新到达各终点的源结点
+			for (size_t j = 0; j < k; j++)
+			{
+				if (terminals[j] == npos)
+					continue;
+				const uint64_t *words = frontier[terminals[j]].words();
+				for (size_t i = 0; i < Block::width / 64; i++)
+					for (uint64_t x = words[i]; x; x &= x - 1)
+					{
+						hops[(first + i * 64 + lowestBit(x)) * k + j] = level;
+						remaining--;
+					}
+			}
+		}
+		PROFILE_COUNT("HopMatrix.batches", 1);
+		PROFILE_COUNT("HopMatrix.levels", levels);
+	}
+
+public:
+	static const unsigned unreached = numeric_limits<unsigned>::max();
+
+	/*
+	 * 构造函数,计算边数矩阵
+	 * _terminals为终点(输入编号),可以重复;mask为不能经过的结点和边
+	 * 不存在或被屏蔽的终点与其他终点(包括自身)之间不可达
+	 */
+	HopMatrix(const Graph<ValueType, IndexType> &graph, const vector<IndexType> &_terminals,
+		const ForbiddenMask<ValueType, IndexType> *mask = nullptr)
+		: k(_terminals.size()), hops(k * k, unreached)
+	{
+		PROFILE_SCOPE("HopMatrix");
+		assert(!mask || mask->current(graph));
+		buildInEdges(graph, mask);
+		for (IndexType v : _terminals)
+		{
+			IndexType s = graph.contains(v) ? graph.inner(v) : npos;
+			terminals.push_back(s != npos && mask && mask->vertex(s) ? npos : s);
+		}
+		//源结点超过64个时每批256个,剩余不超过64个时改用64位
+		for (size_t first = 0; first < k;)
+		{
+			size_t count = k - first;
+			if (count > HopBits64::width)
+			{
+				count = min(count, HopBits256::width);
+				sweep<HopBits256>(first, count);
+			}
+			else
+				sweep<HopBits64>(first, count);
+			first += count;
+		}
+	}
+
+	//终点数
+	size_t size() const
+	{
+		return k;
+	}
+
+	//第i个终点到第j个终点的最少边数,不可达时为unreached
+	unsigned operator()(size_t i, size_t j) const
+	{
+		return hops[i * k + j];
+	}
+};
+
+template <typename ValueType, typename IndexType>
+const unsigned HopMatrix<ValueType, IndexType>::unreached;
+
+#endif // _HOP_MATRIX_H_
@@ -0,0 +1,315 @@
+﻿#ifndef _K_SHORTEST_PATHS_H_		//防止头文件被重复包含
+#define _K_SHORTEST_PATHS_H_
+
+#include "stdafx.h"
+#include "Graph.h"
+
+/*
+ * 惰性k最短简单路径生成器(Yen算法)
+ * 每次调用next按代价从小到大返回vs->ve的下一条无环路径,只在需要时计算下一条
+ * 构造时在反向图上计算一次到ve的最短路径树,所有偏离路径(spur)的搜索共用这棵树：
+ *   1. 偏离结点沿树到ve的路径未被屏蔽时直接使用,不需要搜索
+ *   2. 否则以树上到ve的距离为启发函数进行A*搜索,屏蔽部分结点和边后距离只会变大,因此启发函数可采纳
+ *      出堆结点沿树到ve的路径未被屏蔽时即可结束搜索
+ * 搜索使用的数组在构造时分配,以时间戳代替复位,每次搜索的开销只与访问的结点数有关
+ * 生成器保存graph和mask的引用,使用期间graph和mask不能被销毁或修改
+ * mask为不能经过的结点和边,反向树只在列优先副本中将被屏蔽的边置0,偏离路径的搜索在松弛时检查
+ * 应用举例：
+ * KShortestPaths<double> ksp(graph, 0, 17);
+ * vector<int> path;
+ * double cost;
+ * while (ksp.next(path, cost))
+ *     ...
+ */
+template <typename ValueType, typename IndexType = int>
+class KShortestPaths
+{
+private:
+	typedef typename Graph<ValueType, IndexType>::EdgeIterator EdgeIterator;
+	typedef typename SparseMatrix<ValueType, ColMajor>::InnerIterator InEdgeIterator;
+
+	//候选路径(内部编号),deviation为偏离上一条路径的位置,展开时只需从此位置开始偏离
+	struct Candidate
+	{
+		vector<IndexType> path;
+		ValueType cost;
+		size_t deviation;
+		bool operator<(const Candidate &other) const
+		{
+			return cost != other.cost ? cost < other.cost : path < other.path;
+		}
+	};
+
+	const ValueType unreached = numeric_limits<ValueType>::max();
+	const Graph<ValueType, IndexType> &graph;
+	const ForbiddenMask<ValueType, IndexType> *mask;
+	IndexType source, target;			//内部编号
+	size_t minHops, maxHops;			//输出路径的边数范围
+	size_t expanded;					//已展开的路径数
+
+	//反向最短路径树
+	vector<ValueType> toTarget;			//各结点到target的最短距离
+	vector<IndexType> treeNext;			//各结点在树中的后继结点
+
+	vector<Candidate> accepted;			//已生成的路径
+	set<Candidate> candidates;			//候选路径,按代价排序,set同时去除重复的路径
+
+	//偏离路径搜索的工作区
+	vector<ValueType> dist;
+	vector<IndexType> pred;
+	vector<unsigned> reached;			//reached[v]==searchStamp表示本次搜索中dist[v]有效
+	vector<unsigned> closed;			//closed[v]==searchStamp表示本次搜索中v已出堆
+	vector<unsigned> blocked;			//blocked[v]==blockStamp表示v在当前的根路径上,不能经过
+	vector<IndexType> blockedNext;		//偏离结点不能使用的出边的终点
+	unsigned searchStamp, blockStamp;
+
+	//在反向图上计算各结点到target的最短路径树
+	void buildTree()
+	{
+		size_t n = graph.graph.rows();
+		toTarget.assign(n, unreached);
+		treeNext.assign(n, Graph<ValueType, IndexType>::npos);
+		//列优先的副本中每一列为一个结点的所有入边
+		SparseMatrix<ValueType, ColMajor> inEdges(graph.graph);
+		//被屏蔽的边在副本中一定存在(见ForbiddenMask::refresh),coeffRef不会插入新元素
+		if (mask)
+			for (auto &line : mask->forbiddenLines())
+				inEdges.coeffRef(line.first, line.second) = 0;
+		typedef pair<ValueType, IndexType> HeapItem;
+		priority_queue<HeapItem, vector<HeapItem>, greater<HeapItem>> heap;
+		vector<bool> S(n, false);
+		toTarget[target] = 0;
+		heap.push(HeapItem(0, target));
+		while (!heap.empty())
+		{
+			IndexType k = heap.top().second;
+			heap.pop();
+			if (S[k])
+				continue;
+			S[k] = true;
+			for (InEdgeIterator it(inEdges, k); it; ++it)
+			{
+				IndexType w = static_cast<IndexType>(it.index());
+				if (it.value() != 0 && !S[w] && (!mask || !mask->vertex(w)) && toTarget[k] + it.value() < toTarget[w])
+				{
+					toTarget[w] = toTarget[k] + it.value();
+					treeNext[w] = k;
+					heap.push(HeapItem(toTarget[w], w));
+				}
+			}
+		}
+	}
+
+	//v沿最短路径树到target的路径是否经过被屏蔽的结点
+	bool treePathFree(IndexType v) const
+	{
+		for (; v != target; v = treeNext[v])
+			if (blocked[v] == blockStamp)
+				return false;
+		return true;
+	}
+
+	//将v沿最短路径树到target的路径(不含v)添加到path末尾
+	void appendTreePath(IndexType v, vector<IndexType> &path) const
+	{
+		while (v != target)
+		{
+			v = treeNext[v];
+			path.push_back(v);
+		}
+	}
+
+	/*
+	 * @function name : spurSearch
+	 * @description : 求spur->target不经过被屏蔽结点,且第一条边不在blockedNext中的最短路径
+	 *                spur本身须已被屏蔽
+	 * @outparam : spurPath spur之后的结点,不含spur
+	 * @return : 路径的代价,不存在时为unreached
+	 */
+	ValueType spurSearch(IndexType spur, vector<IndexType> &spurPath)
+	{
+		spurPath.clear();
+		auto isBlockedNext = [&](IndexType v)
+		{
+			return find(blockedNext.begin(), blockedNext.end(), v) != blockedNext.end();
+		};
+		IndexType first = treeNext[spur];
+		if (first != Graph<ValueType, IndexType>::npos && !isBlockedNext(first) && treePathFree(first))
+		{
+			PROFILE_COUNT("KShortestPaths.treeShortcuts", 1);
+			spurPath.push_back(first);
+			appendTreePath(first, spurPath);
+			return toTarget[spur];
+		}
+		//以到target的最短距离为启发函数的A*搜索
+		if (++searchStamp == 0)
+		{
+			fill(reached.begin(), reached.end(), 0);
+			fill(closed.begin(), closed.end(), 0);
+			searchStamp = 1;
+		}
+		typedef pair<ValueType, IndexType> HeapItem;
+		priority_queue<HeapItem, vector<HeapItem>, greater<HeapItem>> heap;
+		size_t settled = 0;
+		dist[spur] = 0;
+		reached[spur] = searchStamp;
+		heap.push(HeapItem(toTarget[spur], spur));
+		IndexType last = Graph<ValueType, IndexType>::npos;		//沿树可直达target的结点
+		while (!heap.empty())
+		{
+			IndexType k = heap.top().second;
+			heap.pop();
+			if (closed[k] == searchStamp)
+				continue;
+			closed[k] = searchStamp;
+			settled++;
+			if (k != spur && treePathFree(k))
+			{
+				last = k;
+				break;
+			}
+			for (EdgeIterator it(graph.graph, k); it; ++it)
+			{
+				IndexType w = static_cast<IndexType>(it.index());
+				//被屏蔽的结点不在反向树中,toTarget为unreached
+				if (it.value() == 0 || blocked[w] == blockStamp || toTarget[w] == unreached ||
+					closed[w] == searchStamp || (k == spur && isBlockedNext(w)) ||
+					(mask && mask->edge(graph.edgeIndex(it))))
+					continue;
+				ValueType d = dist[k] + it.value();
+				if (reached[w] != searchStamp || d < dist[w])
+				{
+					dist[w] = d;
+					pred[w] = k;
+					reached[w] = searchStamp;
+					heap.push(HeapItem(d + toTarget[w], w));
+				}
+			}
+		}
+		PROFILE_COUNT("KShortestPaths.spurSearches", 1);
+		PROFILE_COUNT("KShortestPaths.settled", settled);
+		if (last == Graph<ValueType, IndexType>::npos)
+			return unreached;
+		for (IndexType v = last; v != spur; v = pred[v])
+			spurPath.push_back(v);
+		reverse(spurPath.begin(), spurPath.end());
+		appendTreePath(last, spurPath);
+		return dist[last] + toTarget[last];
+	}
+
+	//以accepted[k]的各结点为偏离结点生成候选路径
+	void expand(size_t k)
+	{
+		PROFILE_SCOPE("KShortestPaths::expand");
+		//accepted在展开期间不会增长,引用保持有效
+		const Candidate &p = accepted[k];
+		if (++blockStamp == 0)
+		{
+			fill(blocked.begin(), blocked.end(), 0);
+			blockStamp = 1;
+		}
+		ValueType rootCost = 0;
+		for (size_t i = 0; i < p.deviation; i++)
+		{
+			blocked[p.path[i]] = blockStamp;
+			rootCost += graph.graph.coeff(p.path[i], p.path[i + 1]);
+		}
+		vector<IndexType> spurPath;
+		for (size_t i = p.deviation; i + 1 < p.path.size(); i++)
+		{
+			IndexType spur = p.path[i];
+			//与p有相同根路径的已生成路径,其在偏离结点的出边不能再使用
+			blockedNext.clear();
+			for (auto &q : accepted)
+				if (q.path.size() > i + 1 && equal(p.path.begin(), p.path.begin() + i + 1, q.path.begin()))
+					blockedNext.push_back(q.path[i + 1]);
+			blocked[spur] = blockStamp;
+			ValueType spurCost = spurSearch(spur, spurPath);
+			if (spurCost != unreached)
+			{
+				Candidate c;
+				c.path.assign(p.path.begin(), p.path.begin() + i + 1);
+				c.path.insert(c.path.end(), spurPath.begin(), spurPath.end());
+				c.cost = rootCost + spurCost;
+				c.deviation = i;
+				candidates.insert(move(c));
+			}
+			rootCost += graph.graph.coeff(spur, p.path[i + 1]);
+		}
+	}
+
+public:
+	/*
+	 * 构造函数,计算反向最短路径树
+	 * vs, ve为起始结点和终止结点
+	 * minHops, maxHops为输出路径的边数范围,范围之外的路径仍会被生成(作为其他路径的偏离基础),但不会输出
+	 * mask为不能经过的结点和边,vs或ve被屏蔽时没有路径
+	 */
+	KShortestPaths(const Graph<ValueType, IndexType> &_graph, IndexType vs, IndexType ve,
+		size_t _minHops = 0, size_t _maxHops = numeric_limits<size_t>::max(),
+		const ForbiddenMask<ValueType, IndexType> *_mask = nullptr)
+		: graph(_graph), mask(_mask), source(_graph.inner(vs)), target(_graph.inner(ve)),
+		minHops(_minHops), maxHops(_maxHops), expanded(0), searchStamp(0), blockStamp(0)
+	{
+		assert(!mask || mask->current(graph));
+		if (!graph.contains(vs) || !graph.contains(ve) || vs == ve ||
+			(mask && (mask->vertex(source) || mask->vertex(target))))
+			return;
+		PROFILE_SCOPE("KShortestPaths::buildTree");
+		buildTree();
+		size_t n = graph.graph.rows();
+		dist.resize(n);
+		pred.resize(n);
+		reached.assign(n, 0);
+		closed.assign(n, 0);
+		blocked.assign(n, 0);
+		//第一条路径即最短路径树上的路径
+		if (toTarget[source] != unreached)
+		{
+			Candidate c;
+			c.path.push_back(source);
+			appendTreePath(source, c.path);
+			c.cost = toTarget[source];
+			c.deviation = 0;
+			candidates.insert(move(c));
+		}
+	}
+
+	/*
+	 * @function name : next
+	 * @description : 生成下一条边数在[minHops, maxHops]范围内的路径
+	 * @outparam : path 路径(输入编号)
+	 * @outparam : cost 路径的代价
+	 * @return : 是否还有路径
+	 */
+	bool next(vector<IndexType> &path, ValueType &cost)
+	{
+		while (true)
+		{
+			//上一条路径在取出下一条路径时才展开
+			if (expanded < accepted.size())
+				expand(expanded++);
+			if (candidates.empty())
+				return false;
+			accepted.push_back(move(const_cast<Candidate &>(*candidates.begin())));
+			candidates.erase(candidates.begin());
+			const Candidate &c = accepted.back();
+			size_t hops = c.path.size() - 1;
+			if (hops < minHops || hops > maxHops)
+				continue;
+			path.resize(c.path.size());
+			for (size_t i = 0; i < path.size(); i++)
+				path[i] = graph.outer(c.path[i]);
+			cost = c.cost;
+			return true;
+		}
+	}
+
+	//已生成的路径数,包括被边数范围过滤的路径
+	size_t count() const
+	{
+		return accepted.size();
+	}
+};
+
+#endif // _K_SHORTEST_PATHS_H_
@@ -0,0 +1,233 @@
+﻿#ifndef _PLANNING_H_		//防止头文件被重复包含
+#define _PLANNING_H_
+
+#include "stdafx.h"
+#include "Graph.h"
+#include "GA.h"
+#include "HopMatrix.h"
+
+//必经结点的访问顺序
+//NodeIdx是必经结点, weight是上一个结点到这个结点的距离,path是这一段的最短路径
+template <typename T, typename IndexType = int>
+struct ListOrder
+{
+	IndexType NodeIdx;
+	vector<IndexType> path;
+	T weight;
+};
+
+
+//从XML文件读取有向图,起止结点,要求的步数,必经结点和线段以及不经结点和线段
+//不经结点和不经线段不从边集中删除,由调用者构造ForbiddenMask在查询时屏蔽
+//返回必经结点与必经线段的总数
+template <typename T>
+size_t loadXML(const char *fileName,
+	vector<pair<Line, T>> &edges,
+	vector<NodeInfo<T>> &greens,
+	vector<int> &redNodes, vector<Line> &redLines,
+	int &start, int &end, int &requiredStep)
+{
+	PROFILE_SCOPE("loadXML");
+	edges.clear();
+	greens.clear();
+	redNodes.clear();
+	redLines.clear();
+	ptree pt;
+	read_xml(fileName, pt);
+	//读取起始结点,终止结点,要求的步数
+	for (auto &aGraph : pt.get_child("Graph"))
+		if (aGraph.first == "<xmlattr>")
+		{
+			start = aGraph.second.get<int>("start");
+			end = aGraph.second.get<int>("end");
+			requiredStep = aGraph.second.get<int>("requiredStep");
+		}
+	//读取有向图所有边
+	for (auto &vEdge : pt.get_child("Graph.Edges"))
+		if (vEdge.first != "<xmlattr>" && vEdge.first != "<xmlcomment>")
+			for (auto &aEdge : vEdge.second)
+				if (aEdge.first == "<xmlattr>")
+					edges.push_back(
+				{
+					{
+						aEdge.second.get<int>("start"),
+						aEdge.second.get<int>("end")
+					},	aEdge.second.get<T>("weight")
+				});
+	//读取不经结点
+	for (auto &vRedNode : pt.get_child("Graph.RedNodes"))
+		if (vRedNode.first != "<xmlattr>" && vRedNode.first != "<xmlcomment>")
+			for (auto &aRedNode : vRedNode.second)
+				if (aRedNode.first == "<xmlattr>")
+					redNodes.push_back(aRedNode.second.get<int>("index"));
+	//读取不经线段
+	for (auto &vRedEdge : pt.get_child("Graph.RedEdges"))
+		if (vRedEdge.first != "<xmlattr>" && vRedEdge.first != "<xmlcomment>")
+			for (auto &aRedEdge : vRedEdge.second)
+				if (aRedEdge.first == "<xmlattr>")
+					redLines.push_back(Line(
+						aRedEdge.second.get<int>("start"),
+						aRedEdge.second.get<int>("end")));
+	//读取必经结点
+	size_t NodeLineCnt = 0;
+	for (auto &vGreenNode : pt.get_child("Graph.GreenNodes"))
+		if (vGreenNode.first != "<xmlattr>" && vGreenNode.first != "<xmlcomment>")
+			for (auto &aGreenNode : vGreenNode.second)
+				if (aGreenNode.first == "<xmlattr>")
+				{
+					greens.push_back(
+						NodeInfo<T>(aGreenNode.second.get<int>("index"))
+					);
+					NodeLineCnt++;
+				}
+	//读取必经线段
+	for (auto &vGreenEdge : pt.get_child("Graph.GreenEdges"))
+		if (vGreenEdge.first != "<xmlattr>" && vGreenEdge.first != "<xmlcomment>")
+			for (auto &aGreenEdge : vGreenEdge.second)
+				if (aGreenEdge.first == "<xmlattr>")
+				{
+					int vs = aGreenEdge.second.get<int>("start");
+					int ve = aGreenEdge.second.get<int>("end");
+					T weight = aGreenEdge.second.get<T>("weight");
+					greens.push_back(NodeInfo<T>(vs, true, ve, weight));
+					greens.push_back(NodeInfo<T>(ve, true, vs, weight));
+					NodeLineCnt++;
+				}
+	return NodeLineCnt;
+}
+
+
+//使用不经结点和不经线段构造graph的屏蔽集合
+template <typename T, typename IndexType>
+ForbiddenMask<T, IndexType> redMask(const Graph<T, IndexType> &graph,
+	const vector<int> &redNodes, const vector<Line> &redLines)
+{
+	ForbiddenMask<T, IndexType> mask(graph);
+	for (int node : redNodes)
+		mask.forbidVertex(static_cast<IndexType>(node));
+	for (auto &line : redLines)
+		mask.forbidEdge(static_cast<IndexType>(line.first), static_cast<IndexType>(line.second));
+	return mask;
+}
+
+/*
+ * @function name : greedyOrder
+ * @description : 从start出发,每次选择距离当前位置最近的未经过的必经结点或线段,最后到达end
+ * @inparam : graph 有向图
+ * @inparam : vecN 必经结点和线段
+ * @inparam : NodeLineCnt 必经结点与必经线段的总数
+ * @inparam : start 起始结点
+ * @inparam : end 终止结点
+ * @inparam : mask 不能经过的结点和边,为空表示不屏蔽
+ * @return : 各段路径,共NodeLineCnt+1段
+ */
+template <typename T, typename IndexType>
+vector<ListOrder<T, IndexType>> greedyOrder(const Graph<T, IndexType> &graph,
+	vector<NodeInfo<T, IndexType>> vecN, size_t NodeLineCnt, IndexType start, IndexType end,
+	const ForbiddenMask<T, IndexType> *mask = nullptr)
+{
+	PROFILE_SCOPE("greedyOrder");
+	for (auto &node : vecN)
+		node.isPassed = false;
+	vector<ListOrder<T, IndexType>> nodeOrder(NodeLineCnt + 1);
+	IndexType current = start;
+	size_t index = 0;
+	for (size_t i = 0; i < NodeLineCnt; i++)
+	{
+		nodeOrder[i].weight = numeric_limits<T>::max();
+		for (size_t j = 0; j < vecN.size(); j++)
+		{
+			if (vecN[j].isPassed)
+				continue;
+			vector<IndexType> path;
+			T weight;
+			weight = graph.shortestPath(current, vecN[j].index, path, mask);
+			if (weight < nodeOrder[i].weight)
+			{
+				nodeOrder[i].weight = weight;
+				nodeOrder[i].NodeIdx = vecN[j].index;
+				nodeOrder[i].path = move(path);
+				index = j;
+			}
+		}
+		vecN[index].isPassed = true;
+		if (vecN[index].isLine)
+		{
+			vecN[pairedLine(vecN, index)].isPassed = true;
+			nodeOrder[i].NodeIdx = vecN[index].reIdx;
+			nodeOrder[i].path.push_back(vecN[index].reIdx);
+			nodeOrder[i].weight += vecN[index].weight;
+		}
+		current = nodeOrder[i].NodeIdx;
+	}
+	nodeOrder[NodeLineCnt].NodeIdx = end;
+	nodeOrder[NodeLineCnt].weight =
+		graph.shortestPath(current, end, nodeOrder[NodeLineCnt].path, mask);
+	return nodeOrder;
+}
+
+/*
+ * @function name : minSteps
+ * @description : 确定需要的最少步数,结果与在无权图上调用greedyOrder相同
+ *                起点,终点和必经结点两两之间的边数由一次位并行多源BFS得到,不需要逐对计算最短路径
+ * @inparam : mask 不能经过的结点和边,为空表示不屏蔽
+ * @return : 贪心路径经过的结点数,不存在经过所有必经结点的路径时返回-1
+ */
+template <typename T, typename IndexType>
+int minSteps(const Graph<T, IndexType> &graph, vector<NodeInfo<T, IndexType>> vecN,
+	size_t NodeLineCnt, IndexType start, IndexType end,
+	const ForbiddenMask<T, IndexType> *mask = nullptr)
+{
+	PROFILE_SCOPE("minSteps");
+	//终点集合: 起点,终点和各必经结点(必经线段的两端),column和reColumn为各必经结点及线段另一端在其中的位置
+	vector<IndexType> terminals = { start, end };
+	auto columnOf = [&](IndexType v)
+	{
+		size_t c = find(terminals.begin(), terminals.end(), v) - terminals.begin();
+		if (c == terminals.size())
+			terminals.push_back(v);
+		return c;
+	};
+	vector<size_t> column(vecN.size()), reColumn(vecN.size());
+	for (size_t j = 0; j < vecN.size(); j++)
+	{
+		column[j] = columnOf(vecN[j].index);
+		if (vecN[j].isLine)
+			reColumn[j] = columnOf(vecN[j].reIdx);
+	}
+	HopMatrix<T, IndexType> hops(graph, terminals, mask);
+
+	//与greedyOrder相同,每次选择边数最少的未经过的必经结点或线段
+	for (auto &node : vecN)
+		node.isPassed = false;
+	size_t current = 0, index = 0;
+	int steps = 0;
+	for (size_t i = 0; i < NodeLineCnt; i++)
+	{
+		unsigned best = HopMatrix<T, IndexType>::unreached;
+		for (size_t j = 0; j < vecN.size(); j++)
+			if (!vecN[j].isPassed && hops(current, column[j]) < best)
+			{
+				best = hops(current, column[j]);
+				index = j;
+			}
+		if (best == HopMatrix<T, IndexType>::unreached)
+			return -1;
+		steps += static_cast<int>(best);
+		vecN[index].isPassed = true;
+		current = column[index];
+		//必经线段经过后到达另一端,多走一步
+		if (vecN[index].isLine)
+		{
+			vecN[pairedLine(vecN, index)].isPassed = true;
+			current = reColumn[index];
+			steps++;
+		}
+	}
+	unsigned last = hops(current, 1);
+	if (last == HopMatrix<T, IndexType>::unreached)
+		return -1;
+	return steps + static_cast<int>(last) + 1;
+}
+
+#endif // _PLANNING_H_
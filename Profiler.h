@@ -0,0 +1,143 @@
+﻿#ifndef _PROFILER_H_		//防止头文件被重复包含
+#define _PROFILER_H_
+
+#include "stdafx.h"
+
+/*
+ * 性能计数器
+ * 编译时定义ENABLE_PROFILING启用(make PROFILE=1),未定义时以下宏全部展开为空,不产生任何开销
+ * PROFILE_SCOPE(name)       统计当前作用域的耗时和执行次数
+ * PROFILE_COUNT(name, n)    计数器name增加n
+ * PROFILE_GAUGE(name, v)    记录name的最新值
+ * 程序退出时将所有计数器以JSON格式写入profile.json,可用环境变量PROFILE_JSON指定输出文件
+ * 计数器可在OpenMP并行区域中使用,热点循环中应先累加到局部变量,循环结束后再调用PROFILE_COUNT
+ */
+
+#ifdef ENABLE_PROFILING
+
+class Profiler
+{
+public:
+	struct Timer
+	{
+		atomic<uint64_t> ns;		//累计耗时(纳秒)
+		atomic<uint64_t> calls;		//执行次数
+		Timer() : ns(0), calls(0) {}
+	};
+
+	static Profiler &instance()
+	{
+		static Profiler profiler;
+		return profiler;
+	}
+
+	//按名称查找计数器,不存在时创建;返回的引用在程序结束前一直有效
+	atomic<uint64_t> &counter(const char *name)
+	{
+		lock_guard<mutex> lock(mtx);
+		return counters[name];
+	}
+
+	Timer &timer(const char *name)
+	{
+		lock_guard<mutex> lock(mtx);
+		return timers[name];
+	}
+
+	void gauge(const char *name, double value)
+	{
+		lock_guard<mutex> lock(mtx);
+		gauges[name] = value;
+	}
+
+	//以JSON格式输出所有计数器
+	void dump(FILE *out)
+	{
+		lock_guard<mutex> lock(mtx);
+		fprintf(out, "{\n\t\"timers\": {");
+		const char *sep = "";
+		for (auto &item : timers)
+		{
+			fprintf(out, "%s\n\t\t\"%s\": { \"calls\": %llu, \"total_ms\": %.3f }", sep, item.first.c_str(),
+				static_cast<unsigned long long>(item.second.calls.load()), item.second.ns.load() / 1e6);
+			sep = ",";
+		}
+		fprintf(out, "\n\t},\n\t\"counters\": {");
+		sep = "";
+		for (auto &item : counters)
+		{
+			fprintf(out, "%s\n\t\t\"%s\": %llu", sep, item.first.c_str(),
+				static_cast<unsigned long long>(item.second.load()));
+			sep = ",";
+		}
+		fprintf(out, "\n\t},\n\t\"gauges\": {");
+		sep = "";
+		for (auto &item : gauges)
+		{
+			fprintf(out, "%s\n\t\t\"%s\": %g", sep, item.first.c_str(), item.second);
+			sep = ",";
+		}
+		fprintf(out, "\n\t}\n}\n");
+	}
+
+	~Profiler()
+	{
+		const char *fileName = getenv("PROFILE_JSON");
+		FILE *out;
+		if (!fopen_s(&out, fileName ? fileName : "profile.json", "w"))
+		{
+			dump(out);
+			fclose(out);
+		}
+	}
+
+private:
+	Profiler() {}
+	mutex mtx;
+	//map的元素地址在插入后不变,可以安全地返回引用
+	map<string, atomic<uint64_t>> counters;
+	map<string, Timer> timers;
+	map<string, double> gauges;
+};
+
+//作用域计时器,析构时累加耗时
+class ScopedTimer
+{
+public:
+	explicit ScopedTimer(Profiler::Timer &_timer)
+		: timer(_timer), begin(chrono::steady_clock::now()) {}
+	~ScopedTimer()
+	{
+		auto ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin).count();
+		timer.ns.fetch_add(static_cast<uint64_t>(ns), memory_order_relaxed);
+		timer.calls.fetch_add(1, memory_order_relaxed);
+	}
+
+private:
+	Profiler::Timer &timer;
+	chrono::steady_clock::time_point begin;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+//每个调用点只查找一次计数器,之后只有一次原子加法
+#define PROFILE_SCOPE(name) \
+	static Profiler::Timer &PROFILE_CONCAT(_profTimer, __LINE__) = Profiler::instance().timer(name); \
+	ScopedTimer PROFILE_CONCAT(_profScope, __LINE__)(PROFILE_CONCAT(_profTimer, __LINE__))
+#define PROFILE_COUNT(name, n) \
+	do { \
+		static atomic<uint64_t> &_profCounter = Profiler::instance().counter(name); \
+		_profCounter.fetch_add(static_cast<uint64_t>(n), memory_order_relaxed); \
+	} while (0)
+#define PROFILE_GAUGE(name, value) Profiler::instance().gauge(name, value)
+
+#else
+
+//sizeof不对参数求值,只用于避免"变量未使用"的编译警告
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNT(name, n) do { (void)sizeof(n); } while (0)
+#define PROFILE_GAUGE(name, value) do { (void)sizeof(value); } while (0)
+
+#endif // ENABLE_PROFILING
+
+#endif // _PROFILER_H_
@@ -0,0 +1,187 @@
+﻿#ifndef _VERTEX_ORDER_H_		//防止头文件被重复包含
+#define _VERTEX_ORDER_H_
+
+#include "stdafx.h"
+
+/*
+ * 顶点重排序方式
+ * 输入文件中的顶点编号是任意的,相邻结点在关联矩阵中可能相距很远
+ * 构造Graph时按以下方式重新编号,可使相邻结点的存储位置更接近,提升遍历时的缓存命中率
+ */
+enum class VertexOrder
+{
+	None,		//保持输入文件中的编号
+	BFS,		//广度优先遍历顺序
+	RCM,		//逆Cuthill-McKee顺序,减小关联矩阵的带宽
+	Hilbert		//按顶点坐标在Hilbert曲线上的顺序,需要提供顶点坐标
+};
+
+//顶点的平面坐标
+typedef pair<double, double> Point;
+
+/*
+ * @function name : bfsVertexOrder
+ * @description : 按广度优先顺序对顶点编号,每个连通分量从度数最小的结点开始遍历
+ * @inparam : offset, adj 无向邻接表(CSR格式),结点u的邻居为adj[offset[u]] ~ adj[offset[u+1]-1]
+ * @inparam : byDegree 为true时按度数从小到大访问邻居(Cuthill-McKee)
+ * @return : 新编号->原编号
+ */
+inline vector<int> bfsVertexOrder(const vector<size_t> &offset, const vector<int> &adj, bool byDegree)
+{
+	size_t n = offset.size() - 1;
+	auto degree = [&](int v) { return offset[v + 1] - offset[v]; };
+	//按度数从小到大排列的结点,用于选取每个连通分量的起始结点
+	vector<int> starts(n);
+	for (size_t v = 0; v < n; v++)
+		starts[v] = static_cast<int>(v);
+	stable_sort(starts.begin(), starts.end(), [&](int x, int y)
+	{
+		return degree(x) < degree(y);
+	});
+	vector<int> order;
+	order.reserve(n);
+	vector<bool> visited(n, false);
+	vector<int> next;
+	for (int s : starts)
+	{
+		if (visited[s])
+			continue;
+		visited[s] = true;
+		order.push_back(s);
+		//order本身作为队列使用
+		for (size_t head = order.size() - 1; head < order.size(); head++)
+		{
+			int u = order[head];
+			next.clear();
+			for (size_t e = offset[u]; e < offset[u + 1]; e++)
+				if (!visited[adj[e]])
+				{
+					visited[adj[e]] = true;
+					next.push_back(adj[e]);
+				}
+			if (byDegree)
+				stable_sort(next.begin(), next.end(), [&](int x, int y)
+				{
+					return degree(x) < degree(y);
+				});
+			order.insert(order.end(), next.begin(), next.end());
+		}
+	}
+	return order;
+}
+
+//计算(x,y)在边长为2^16的网格上的Hilbert曲线序号
+inline uint64_t hilbertIndex(uint32_t x, uint32_t y)
+{
+	uint64_t d = 0;
+	for (uint32_t s = 1u << 15; s > 0; s >>= 1)
+	{
+		uint32_t rx = (x & s) ? 1 : 0;
+		uint32_t ry = (y & s) ? 1 : 0;
+		d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+		//旋转象限
+		if (ry == 0)
+		{
+			if (rx == 1)
+			{
+				x = s - 1 - x;
+				y = s - 1 - y;
+			}
+			swap(x, y);
+		}
+	}
+	return d;
+}
+
+/*
+ * @function name : hilbertVertexOrder
+ * @description : 将顶点坐标缩放到2^16×2^16的网格,按Hilbert曲线序号排序
+ * @inparam : coords 顶点坐标
+ * @return : 新编号->原编号
+ */
+inline vector<int> hilbertVertexOrder(const vector<Point> &coords)
+{
+	size_t n = coords.size();
+	double minX = numeric_limits<double>::max(), maxX = -numeric_limits<double>::max();
+	double minY = minX, maxY = maxX;
+	for (auto &p : coords)
+	{
+		minX = min(minX, p.first);
+		maxX = max(maxX, p.first);
+		minY = min(minY, p.second);
+		maxY = max(maxY, p.second);
+	}
+	double scaleX = maxX > minX ? 65535.0 / (maxX - minX) : 0;
+	double scaleY = maxY > minY ? 65535.0 / (maxY - minY) : 0;
+	vector<uint64_t> key(n);
+	for (size_t v = 0; v < n; v++)
+		key[v] = hilbertIndex(
+			static_cast<uint32_t>((coords[v].first - minX) * scaleX),
+			static_cast<uint32_t>((coords[v].second - minY) * scaleY));
+	vector<int> order(n);
+	for (size_t v = 0; v < n; v++)
+		order[v] = static_cast<int>(v);
+	stable_sort(order.begin(), order.end(), [&](int x, int y)
+	{
+		return key[x] < key[y];
+	});
+	return order;
+}
+
+/*
+ * @function name : computeVertexOrder
+ * @description : 计算顶点的重排序
+ * @inparam : n 顶点数
+ * @inparam : lines 有向图的所有边(原编号)
+ * @inparam : order 重排序方式
+ * @inparam : coords 顶点坐标,仅Hilbert方式使用;坐标缺失时退化为RCM
+ * @return : 新编号->原编号,返回空数组表示不重排序
+ */
+inline vector<int> computeVertexOrder(
+	size_t n, const vector<pair<int, int>> &lines,
+	VertexOrder order, const vector<Point> *coords = nullptr
+)
+{
+	if (order == VertexOrder::None || n == 0)
+		return vector<int>();
+	if (order == VertexOrder::Hilbert && coords && coords->size() >= n)
+		return hilbertVertexOrder(vector<Point>(coords->begin(), coords->begin() + n));
+	//建立无向邻接表,重排序只关心结点间是否相邻,不关心边的方向
+	vector<size_t> offset(n + 1, 0);
+	for (auto &line : lines)
+		if (line.first != line.second)
+		{
+			offset[line.first + 1]++;
+			offset[line.second + 1]++;
+		}
+	for (size_t v = 0; v < n; v++)
+		offset[v + 1] += offset[v];
+	vector<int> adj(offset[n]);
+	vector<size_t> pos(offset.begin(), offset.end() - 1);
+	for (auto &line : lines)
+		if (line.first != line.second)
+		{
+			adj[pos[line.first]++] = line.second;
+			adj[pos[line.second]++] = line.first;
+		}
+	//去除双向边产生的重复邻居
+	vector<size_t> compact(n + 1, 0);
+	size_t cnt = 0;
+	for (size_t v = 0; v < n; v++)
+	{
+		sort(adj.begin() + offset[v], adj.begin() + offset[v + 1]);
+		auto last = unique(adj.begin() + offset[v], adj.begin() + offset[v + 1]);
+		for (auto it = adj.begin() + offset[v]; it != last; ++it)
+			adj[cnt++] = *it;
+		compact[v + 1] = cnt;
+	}
+	adj.resize(cnt);
+	if (order == VertexOrder::BFS)
+		return bfsVertexOrder(compact, adj, false);
+	//RCM: Cuthill-McKee顺序取反
+	vector<int> result = bfsVertexOrder(compact, adj, true);
+	reverse(result.begin(), result.end());
+	return result;
+}
+
+#endif // _VERTEX_ORDER_H_
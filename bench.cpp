@@ -0,0 +1,360 @@
+﻿//性能测试：在合成图上测量各算法的耗时,结果以JSON Lines格式输出,每行一条记录
+//用法：bench [输出文件(默认bench.json)] [最大顶点数(默认16384)]
+
+#include "stdafx.h"
+#include "Graph.h"
+#include "GA.h"
+#include "KShortestPaths.h"
+#include "DynamicPaths.h"
+#include "HopFront.h"
+#include "HopMatrix.h"
+#include "Planning.h"
+#include "Generator.h"
+
+#ifdef _OPENMP
+#	include <omp.h>
+#endif
+
+#ifdef _WIN32
+#	include <windows.h>
+#	include <psapi.h>
+#else
+#	include <sys/resource.h>
+#endif
+
+//进程的峰值常驻内存(KB)
+size_t peakRSS()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS info;
+	GetProcessMemoryInfo(GetCurrentProcess(), &info, sizeof(info));
+	return info.PeakWorkingSetSize / 1024;
+#else
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+#endif
+}
+
+//一个测试场景：合成图,起止结点和必经结点
+struct Scenario
+{
+	string name;
+	vector<pair<Line, double>> edges;
+	vector<Point> coords;
+	int numVertexes;
+	int start, end;
+	int hops;		//start->end的最少边数
+	vector<NodeInfo<double>> greens;
+	size_t NodeLineCnt;
+};
+
+//在无向边集上广度优先遍历,返回各结点到src的边数,不可达为-1
+vector<int> hopDistances(const vector<pair<Line, double>> &edges, int n, int src)
+{
+	vector<vector<int>> adj(n);
+	for (auto &edge : edges)
+		adj[edge.first.first].push_back(edge.first.second);
+	vector<int> hops(n, -1);
+	queue<int> q;
+	hops[src] = 0;
+	q.push(src);
+	while (!q.empty())
+	{
+		int u = q.front();
+		q.pop();
+		for (int v : adj[u])
+			if (hops[v] == -1)
+			{
+				hops[v] = hops[u] + 1;
+				q.push(v);
+			}
+	}
+	return hops;
+}
+
+//删除随机的不经结点和线段,在start所在的连通分量内选取终点(最远的结点)和必经结点
+Scenario makeScenario(const string &name, vector<pair<Line, double>> edges,
+	vector<Point> coords, int n, unsigned seed)
+{
+	Scenario sc;
+	sc.name = name;
+	sc.numVertexes = n;
+	removeRandomReds(edges, n / 100, n / 100, set<int>(), seed);
+	sc.start = edges[0].first.first;
+	vector<int> hops = hopDistances(edges, n, sc.start);
+	sc.end = static_cast<int>(max_element(hops.begin(), hops.end()) - hops.begin());
+	sc.hops = hops[sc.end];
+	//必经结点只在start所在的连通分量中选取
+	vector<pair<Line, double>> reachable;
+	for (auto &edge : edges)
+		if (hops[edge.first.first] != -1)
+			reachable.push_back(edge);
+	//与Graph.xml相同,使用2个必经结点和2条必经线段
+	sc.greens = randomGreens(reachable, 2, 2, { sc.start, sc.end }, seed);
+	//连通分量较小时可能选不足,按实际生成的个数计算;每条必经线段在greens中占两项(两个方向)
+	sc.NodeLineCnt = 0;
+	for (auto &green : sc.greens)
+		sc.NodeLineCnt += green.isLine ? 1 : 2;
+	sc.NodeLineCnt /= 2;
+	sc.edges = move(edges);
+	sc.coords = move(coords);
+	return sc;
+}
+
+//统计结果并输出一条JSON记录
+void report(FILE *out, const Scenario &sc, const char *op, const char *variant,
+	int threads, vector<double> samples)
+{
+	sort(samples.begin(), samples.end());
+	size_t count = samples.size();
+	double total = 0;
+	for (double t : samples)
+		total += t;
+	double median = count % 2 ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) / 2;
+	size_t p99Idx = static_cast<size_t>(ceil(0.99 * count)) - 1;
+	double p99 = samples[min(p99Idx, count - 1)];
+	fprintf(out,
+		"{\"op\":\"%s\",\"variant\":\"%s\",\"graph\":\"%s\",\"vertices\":%d,\"edges\":%zu,"
+		"\"threads\":%d,\"reps\":%zu,\"median_us\":%.3f,\"p99_us\":%.3f,"
+		"\"throughput_ops\":%.3f}\n",
+		op, variant, sc.name.c_str(), sc.numVertexes, sc.edges.size(),
+		threads, count, median, p99, total > 0 ? count / (total * 1e-6) : 0.0);
+	fflush(out);
+	fprintf(stderr, "%-32s %-8s %-10s n=%-6d threads=%d median=%.1fus p99=%.1fus\n",
+		op, variant, sc.name.c_str(), sc.numVertexes, threads, median, p99);
+}
+
+//测量func执行reps次的耗时(微秒)
+template <typename Func>
+vector<double> measure(size_t reps, Func func)
+{
+	vector<double> samples;
+	for (size_t r = 0; r < reps; r++)
+	{
+		auto begin = chrono::steady_clock::now();
+		func(r);
+		auto end = chrono::steady_clock::now();
+		samples.push_back(chrono::duration<double, micro>(end - begin).count());
+	}
+	return samples;
+}
+
+void runScenario(FILE *out, const Scenario &sc, int threads)
+{
+	mt19937 rng(12345);
+	uniform_int_distribution<int> vertex(0, sc.numVertexes - 1);
+
+	//构造有向图,分别测量不重排序和各重排序方式
+	const pair<VertexOrder, const char *> orders[] =
+	{
+		{ VertexOrder::None, "none" },
+		{ VertexOrder::BFS, "bfs" },
+		{ VertexOrder::RCM, "rcm" },
+		{ VertexOrder::Hilbert, "hilbert" }
+	};
+	for (auto &order : orders)
+	{
+		if (order.first == VertexOrder::Hilbert && sc.coords.empty())
+			continue;
+		report(out, sc, "construct", order.second, threads, measure(5, [&](size_t)
+		{
+			Graph<double> graph(sc.edges, order.first, &sc.coords);
+		}));
+	}
+
+	Graph<double> graph(sc.edges, VertexOrder::RCM, &sc.coords);
+
+	//随机结点对之间的最短路径
+	vector<pair<int, int>> queries(100);
+	for (auto &q : queries)
+		q = { vertex(rng), vertex(rng) };
+	report(out, sc, "shortestPath", "rcm", threads, measure(queries.size(), [&](size_t r)
+	{
+		vector<int> path;
+		graph.shortestPath(queries[r].first, queries[r].second, path);
+	}));
+
+	//每个请求的不经结点和线段(各n/100个)在查询时屏蔽,测量更换屏蔽集合和屏蔽后查询的开销
+	ForbiddenMask<double> mask(graph);
+	uniform_int_distribution<size_t> edge(0, sc.edges.size() - 1);
+	report(out, sc, "ForbiddenMask::update", "rcm", threads, measure(100, [&](size_t)
+	{
+		mask.clear();
+		for (int i = 0; i < max(1, sc.numVertexes / 100); i++)
+		{
+			mask.forbidVertex(vertex(rng));
+			const Line &line = sc.edges[edge(rng)].first;
+			mask.forbidEdge(line.first, line.second);
+		}
+	}));
+	report(out, sc, "shortestPath", "masked", threads, measure(queries.size(), [&](size_t r)
+	{
+		vector<int> path;
+		graph.shortestPath(queries[r].first, queries[r].second, path, &mask);
+	}));
+
+	//start->end的结点数受限最短路径,结点数比最少结点数多4
+	report(out, sc, "verticeConstrainedShortestPath", "rcm", threads, measure(10, [&](size_t)
+	{
+		vector<int> path;
+		graph.verticeConstrainedShortestPath(sc.start, sc.end, sc.hops + 5, path);
+	}));
+
+	//边数为最少边数~最少边数+4的代价,逐个调用verticeConstrainedShortestPath与一次计算Pareto前沿对比
+	report(out, sc, "verticeConstrainedShortestPath", "sweep5", threads, measure(10, [&](size_t)
+	{
+		vector<int> path;
+		for (int k = sc.hops + 1; k <= sc.hops + 5; k++)
+			graph.verticeConstrainedShortestPath(sc.start, sc.end, k, path);
+	}));
+	report(out, sc, "HopFront", "sweep5", threads, measure(10, [&](size_t)
+	{
+		HopFront<double> front(graph, sc.start, sc.hops + 4);
+		vector<int> path;
+		for (int h = sc.hops; h <= sc.hops + 4; h++)
+			front.path(sc.end, h, path);
+	}));
+
+	//start->end的前10条最短简单路径
+	report(out, sc, "KShortestPaths", "k10", threads, measure(10, [&](size_t)
+	{
+		KShortestPaths<double> ksp(graph, sc.start, sc.end);
+		vector<int> path;
+		double cost;
+		for (int k = 0; k < 10 && ksp.next(path, cost); k++)
+			;
+	}));
+
+	//动态修改：维护起点,终点和必经结点的最短路径树,每批随机修改10条边的权值后增量修复
+	//setTerminals的耗时即为每次修改后全部重新计算的开销
+	{
+		Graph<double> dynamicGraph(sc.edges, VertexOrder::RCM, &sc.coords);
+		DynamicShortestPaths<double> dsp(dynamicGraph);
+		vector<int> terminals = { sc.start, sc.end };
+		for (auto &green : sc.greens)
+			if (find(terminals.begin(), terminals.end(), green.index) == terminals.end())
+				terminals.push_back(green.index);
+		report(out, sc, "DynamicShortestPaths::setTerminals", "rcm", threads, measure(1, [&](size_t)
+		{
+			dsp.setTerminals(terminals);
+		}));
+		uniform_int_distribution<int> weight(1, 9);
+		report(out, sc, "DynamicShortestPaths::update", "reweight10", threads, measure(20, [&](size_t)
+		{
+			vector<pair<Line, double>> batch;
+			for (int i = 0; i < 10; i++)
+				batch.push_back({ sc.edges[edge(rng)].first, static_cast<double>(weight(rng)) });
+			dsp.update(batch);
+		}));
+	}
+
+	report(out, sc, "greedyOrder", "rcm", threads, measure(10, [&](size_t)
+	{
+		greedyOrder(graph, sc.greens, sc.NodeLineCnt, sc.start, sc.end);
+	}));
+
+	int steps = 0;
+	report(out, sc, "minSteps", "rcm", threads, measure(10, [&](size_t)
+	{
+		steps = minSteps(graph, sc.greens, sc.NodeLineCnt, sc.start, sc.end);
+	}));
+
+	//随机选取的64个和256个终点两两之间的边数,分别使用64位和256位的位集合
+	const pair<int, const char *> terminalCounts[] = { { 64, "terminals64" }, { 256, "terminals256" } };
+	for (auto &count : terminalCounts)
+	{
+		vector<int> terminals(count.first);
+		for (auto &v : terminals)
+			v = vertex(rng);
+		report(out, sc, "HopMatrix", count.second, threads, measure(3, [&](size_t)
+		{
+			HopMatrix<double> hops(graph, terminals);
+		}));
+	}
+
+	//遗传算法在每种规模上都测量,较大的图上随机游走很难恰好到达终点,以截止时间限制每次求解的耗时
+	const auto gaLimit = chrono::seconds(2);
+	//随机游走必须恰好在第PATH_LENGTH个结点到达终点,二分图(如网格)中步数的奇偶性需与最少边数一致
+	size_t pathLength = max(steps, sc.hops + 1);
+	if ((pathLength - 1 - sc.hops) % 2)
+		pathLength++;
+	report(out, sc, "GA::Solve", "rcm", threads, measure(3, [&](size_t)
+	{
+		vector<NodeInfo<double>> vecN = sc.greens;
+		GA<double> ga(graph, vecN, sc.start, sc.end, pathLength, 200, 100);
+		GA<double>::SolveOptions options;
+		ga.Solve(options.timeout(gaLimit));
+	}));
+
+	//不进行局部搜索的遗传算法,用于对比memetic算法的效果
+	report(out, sc, "GA::Solve", "noLocalSearch", threads, measure(3, [&](size_t)
+	{
+		vector<NodeInfo<double>> vecN = sc.greens;
+		GA<double> ga(graph, vecN, sc.start, sc.end, pathLength, 200, 100);
+		GA<double>::SolveOptions options;
+		options.localSearch = false;
+		ga.Solve(options.timeout(gaLimit));
+	}));
+
+	//限时求解,截止时间为10ms时的实际延迟
+	report(out, sc, "GA::Solve", "deadline10ms", threads, measure(5, [&](size_t)
+	{
+		vector<NodeInfo<double>> vecN = sc.greens;
+		GA<double> ga(graph, vecN, sc.start, sc.end, pathLength, 200, 100);
+		GA<double>::SolveOptions options;
+		ga.Solve(options.timeout(chrono::milliseconds(10)));
+	}));
+}
+
+int main(int argc, char *argv[])
+{
+	const char *outName = argc > 1 ? argv[1] : "bench.json";
+	int maxVertexes = argc > 2 ? atoi(argv[2]) : 16384;
+	FILE *out;
+	if (fopen_s(&out, outName, "w"))
+	{
+		printf("无法打开%s\n", outName);
+		return 1;
+	}
+	srand(12345);
+
+	vector<int> threadCounts = { 1 };
+#ifdef _OPENMP
+	if (omp_get_max_threads() > 1)
+		threadCounts.push_back(omp_get_max_threads());
+#endif
+
+	for (int n = 64; n <= maxVertexes; n *= 4)
+	{
+		int side = static_cast<int>(sqrt(n));
+		vector<Scenario> scenarios;
+		{
+			vector<Point> coords;
+			auto edges = gridGraph(side, side, n, &coords);
+			scenarios.push_back(makeScenario("grid", move(edges), move(coords), side * side, n));
+		}
+		{
+			vector<Point> coords;
+			//半径使平均度数约为8
+			auto edges = randomGeometricGraph(n, sqrt(8.0 / (3.14159 * n)), n, &coords);
+			scenarios.push_back(makeScenario("geometric", move(edges), move(coords), n, n));
+		}
+		scenarios.push_back(makeScenario("erdos-renyi", erdosRenyiGraph(n, 8, n), vector<Point>(), n, n));
+		scenarios.push_back(makeScenario("scale-free", scaleFreeGraph(n, 4, n), vector<Point>(), n, n));
+
+		for (auto &sc : scenarios)
+			for (int threads : threadCounts)
+			{
+#ifdef _OPENMP
+				omp_set_num_threads(threads);
+#endif
+				runScenario(out, sc, threads);
+			}
+	}
+	//峰值常驻内存是整个进程的最大值,只在最后输出一次
+	fprintf(out, "{\"op\":\"process\",\"peak_rss_kb\":%zu}\n", peakRSS());
+	fprintf(stderr, "peak RSS %zu KB\n", peakRSS());
+	fclose(out);
+	return 0;
+}
@@ -43,6 +43,27 @@
 #include <cstdlib>
 #include <ctime>
 #include <list>
+#include <set>
+#include <random>			//合成图生成器使用的随机数引擎
+#include <chrono>
+#include <map>
+#include <atomic>			//性能计数器,可在OpenMP并行区域中使用
+#include <mutex>
+#include <queue>			//Dijkstra算法使用的优先队列
+#include <algorithm>
+#include <functional>
+#include <type_traits>		//Graph和GA的模板参数检查
+#include <cstdint>
+#include <stdexcept>
+#ifdef __AVX__
+#include <immintrin.h>		//多源BFS的256位位运算
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>			//_BitScanForward64
+#endif
+#ifdef _OPENMP
+#include <omp.h>			//遗传算法局部搜索按线程编号选取工作区
+#endif
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 